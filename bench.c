@@ -0,0 +1,631 @@
+#include "editor.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+//headless benchmark, drives the editor library on SDL's offscreen video
+//driver and prints one JSON object with a record per workload:
+//throughput and latency percentiles of single operations, peak RSS is a
+//process high water mark so it is reported once for the whole run
+//
+//  SimpleEditorBench [--sizes 1,100,1024] [--ops N] [--frames N]
+//                    [--dir path] [--keep]
+//  SimpleEditorBench --replay session.rec --file input [--log events.csv]
+//  SimpleEditorBench --check [--dir path]
+//
+//sizes are MB of generated code to load, edits and rendering run on the
+//first one, files are removed afterwards unless --keep
+//
+//--replay feeds a session recorded by SimpleEditorC --record through the
+//same input and render path against input, and reports the per event
+//times and a hash of the final text so builds can be compared
+//
+//--check records a short session of its own, replays it twice and exits
+//non-zero unless the input is unchanged and both hashes agree even with
+//the clipboard changed in between, ctest runs it
+
+#define BENCH_MAX_SIZES 8
+#define BENCH_CHUNK (1 << 20) //generated bytes written per call
+#define BENCH_TAB_BYTES (256 << 10) //each file of the tabs workload
+#define BENCH_TAB_BUDGET ((size_t)16 << 20) //so the strided views evict
+
+typedef struct {
+  Uint64 *ns; //one sample per operation
+  size_t n;
+  size_t cap;
+} Samples;
+
+static Uint64 rngState = 0x9E3779B97F4A7C15ull;
+static int nreports = 0;
+
+static Uint32 rng(void) {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return (Uint32)rngState;
+}
+
+static void samples_add(Samples *s, Uint64 ns) {
+  if (s->n == s->cap) {
+    size_t new_cap = s->cap ? s->cap * 2 : 1024;
+    Uint64 *grown = realloc(s->ns, sizeof(Uint64) * new_cap);
+    if (grown == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    s->ns = grown;
+    s->cap = new_cap;
+  }
+  s->ns[s->n++] = ns;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  Uint64 x = *(const Uint64*)a;
+  Uint64 y = *(const Uint64*)b;
+  return x < y ? -1 : x > y;
+}
+
+static double percentile_us(const Samples *s, double q) {
+  if (s->n == 0) return 0;
+  size_t k = (size_t)(q * (s->n - 1) + 0.5);
+  return s->ns[k] / 1000.0;
+}
+
+//kilobytes, -1 where the platform does not say
+static long peak_rss_kb(void) {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+  return ru.ru_maxrss / 1024; //bytes there
+#else
+  return ru.ru_maxrss;
+#endif
+#else
+  return -1;
+#endif
+}
+
+//one workload record, units processed over totalNs, samples are emptied
+static void report(const char *name, double units, const char *unit, Uint64 totalNs, Samples *s) {
+  qsort(s->ns, s->n, sizeof(Uint64), cmp_u64);
+  double seconds = totalNs / 1e9;
+  printf("%s\n    {\"name\":\"%s\",\"ops\":%zu,\"seconds\":%.6f,\"throughput\":%.3f,\"unit\":\"%s\","
+         "\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f}",
+         nreports ? "," : "", name, s->n, seconds, seconds > 0 ? units / seconds : 0, unit,
+         percentile_us(s, 0.5), percentile_us(s, 0.9), percentile_us(s, 0.99), percentile_us(s, 1.0));
+  fflush(stdout);
+  nreports++;
+  s->n = 0;
+}
+
+//dense C, short and long lines, comments, strings and blank lines
+static const char *templates[] = {
+  "static int compute_%u(const struct node *n, size_t count) {\n",
+  "  for (size_t i = 0; i < count; i++) total += n[i].value * %u + (n[i].flags >> 3); //accumulate\n",
+  "  if (flags & 0x%x) return \"string literal with escapes \\\" %u\";\n",
+  "  /* block comment %u spanning one line */ x = y + z;\n",
+  "  buffer[%u] = '\\n';\n",
+  "}\n",
+  "\n",
+};
+
+//at least n bytes of generated lines, dst needs 256 bytes past n
+static size_t bench_text(char *dst, size_t n) {
+  size_t k = 0;
+  while (k < n) {
+    Uint32 r = rng();
+    k += snprintf(dst + k, 256, templates[r % SDL_arraysize(templates)], r >> 8, r >> 12);
+  }
+  return k;
+}
+
+static int bench_generate(const char *path, size_t bytes) {
+  SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+  if (io == NULL) {
+    fprintf(stderr, "Cannot create %s: %s\n", path, SDL_GetError());
+    return -1;
+  }
+  char *chunk = malloc(BENCH_CHUNK + 256);
+  if (chunk == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t written = 0;
+  int ok = 1;
+  while (ok && written < bytes) {
+    size_t n = bench_text(chunk, BENCH_CHUNK);
+    if (n > bytes - written) n = bytes - written;
+    ok = SDL_WriteIO(io, chunk, n) == n;
+    written += n;
+  }
+  free(chunk);
+  if (!SDL_CloseIO(io) || !ok) {
+    fprintf(stderr, "Cannot write %s: %s\n", path, SDL_GetError());
+    return -1;
+  }
+  return 0;
+}
+
+static void bench_open(const char *path) {
+  currFile cfile;
+  openCurFile(&cfile, path);
+  buffer_init(&buffer, 1);
+  readFile(&cfile, &buffer);
+  closeCurFile(&cfile);
+}
+
+static void bench_close(void) {
+  buffer_free(&buffer);
+  col_cache_free();
+  wrap_cache_free();
+  //loaders wake the main loop per batch, nobody reads those here
+  SDL_FlushEvent(loadEventType);
+  scrollX = 0;
+  scrollY = 0;
+  cursor_Line = 0;
+  cursor_Pos = 0;
+}
+
+//time to first lines and to the whole file indexed
+static void bench_load(const char *path, size_t megabytes, Samples *s) {
+  char name[64];
+  Uint64 t0 = SDL_GetTicksNS();
+  bench_open(path);
+  samples_add(s, SDL_GetTicksNS() - t0);
+  snprintf(name, sizeof(name), "load_%zumb_first_lines", megabytes);
+  report(name, 1, "opens/s", s->ns[0], s);
+
+  buffer_wait_lines(&buffer, SIZE_MAX);
+  Uint64 total = SDL_GetTicksNS() - t0;
+  samples_add(s, total);
+  snprintf(name, sizeof(name), "load_%zumb", megabytes);
+  report(name, megabytes, "MB/s", total, s);
+  bench_close();
+}
+
+//random position, mostly single byte inserts and deletes like typing
+static void bench_random_edits(size_t ops, Samples *s) {
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t k = 0; k < ops; k++) {
+    size_t line = rng() % buffer.nlines;
+    size_t len = buffer_get_line(&buffer, line)->length;
+    size_t pos = len ? rng() % len : 0;
+    Uint64 t = SDL_GetTicksNS();
+    if (rng() % 5 < 3 || len == 0) buffer_edit_insert(&buffer, line, pos, "x", 1);
+    else buffer_edit_delete(&buffer, line, pos, 1);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("edit_random", ops, "ops/s", SDL_GetTicksNS() - t0, s);
+}
+
+//split lines and join them back, every op moves the line array
+static void bench_newline_edits(size_t ops, Samples *s) {
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t k = 0; k < ops; k++) {
+    size_t line = rng() % buffer.nlines;
+    String *l = buffer_get_line(&buffer, line);
+    Uint64 t = SDL_GetTicksNS();
+    if (k % 2 == 0) {
+      buffer_edit_insert(&buffer, line, l->length ? rng() % l->length : 0, "\n", 1);
+    } else if (l->length > 0 && line + 1 < buffer.nlines) {
+      //drop the line break, the next line joins this one
+      buffer_edit_delete(&buffer, line, l->length - 1, 1);
+    } else {
+      continue;
+    }
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("edit_newlines", s->n, "ops/s", SDL_GetTicksNS() - t0, s);
+}
+
+//a block of generated code pasted into the middle of the file and cut
+//again, next to a memcpy of the same bytes as the floor
+static void bench_paste(size_t megabytes, Samples *s) {
+  char name[64];
+  size_t n = megabytes << 20;
+  char *text = malloc(n + 256);
+  char *copy = malloc(n);
+  if (text == NULL || copy == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  bench_text(text, n);
+  Uint64 t = SDL_GetTicksNS();
+  memcpy(copy, text, n);
+  samples_add(s, SDL_GetTicksNS() - t);
+  snprintf(name, sizeof(name), "memcpy_%zumb", megabytes);
+  report(name, megabytes, "MB/s", s->ns[0], s);
+
+  size_t line = buffer.nlines / 2;
+  t = SDL_GetTicksNS();
+  buffer_edit_insert(&buffer, line, 0, copy, n);
+  samples_add(s, SDL_GetTicksNS() - t);
+  snprintf(name, sizeof(name), "paste_%zumb", megabytes);
+  report(name, megabytes, "MB/s", s->ns[0], s);
+
+  t = SDL_GetTicksNS();
+  buffer_edit_delete(&buffer, line, 0, n);
+  samples_add(s, SDL_GetTicksNS() - t);
+  snprintf(name, sizeof(name), "cut_%zumb", megabytes);
+  report(name, megabytes, "MB/s", s->ns[0], s);
+  free(copy);
+  free(text);
+}
+
+//many files at once: opening them, first views that read each file and
+//views that come back to a parked or evicted tab, under a small budget
+static int bench_tabs(const char *dir, size_t count, int keep, Samples *s) {
+  char **paths = malloc(sizeof(char*) * count);
+  if (paths == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t k = 0; k < count; k++) {
+    paths[k] = malloc(512);
+    if (paths[k] == NULL) {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    snprintf(paths[k], 512, "%s/bench_tab_%zu.c", dir, k);
+    if (bench_generate(paths[k], BENCH_TAB_BYTES) != 0) return -1;
+  }
+  char name[64];
+  Uint64 t = SDL_GetTicksNS();
+  tabs_open(paths, count, BENCH_TAB_BUDGET);
+  samples_add(s, SDL_GetTicksNS() - t);
+  snprintf(name, sizeof(name), "tabs_open_%zu", count);
+  report(name, count, "files/s", s->ns[0], s);
+
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t k = 0; k < count; k++) {
+    t = SDL_GetTicksNS();
+    tabs_show(k);
+    buffer_wait_lines(&buffer, SIZE_MAX);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("tabs_show_first", count, "tabs/s", SDL_GetTicksNS() - t0, s);
+
+  //strided so parked and evicted tabs mix
+  t0 = SDL_GetTicksNS();
+  for (size_t k = 0; k < count; k++) {
+    t = SDL_GetTicksNS();
+    tabs_show(k * 7 % count);
+    buffer_wait_lines(&buffer, SIZE_MAX);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("tabs_show_again", count, "tabs/s", SDL_GetTicksNS() - t0, s);
+  tabs_free();
+  SDL_FlushEvent(loadEventType);
+  for (size_t k = 0; k < count; k++) {
+    if (!keep) remove(paths[k]);
+    free(paths[k]);
+  }
+  free(paths);
+  return 0;
+}
+
+static void bench_ui_init(Cursor *cursor, Panel *panel) {
+  initCursor(cursor);
+  initPanel(panel);
+  batch_init(&glyphBatch, fontAtlas, 4096);
+  glyph_cache_init(&glyphCache);
+  damage_resize();
+}
+
+static void bench_ui_free(Cursor *cursor, Panel *panel) {
+  damage_free();
+  glyph_cache_free(&glyphCache);
+  batch_free(&glyphBatch);
+  freePanel(panel);
+  freeCursor(cursor);
+}
+
+//whole frames over the middle of the file
+static void bench_render(Cursor *cursor, Panel *panel, size_t frames, Samples *s) {
+  scrollY = (int)(buffer.nlines / 2) * FONT_SIZE;
+  cursor_Line = buffer.nlines / 2;
+  cursor_Pos = 0;
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t k = 0; k < frames; k++) {
+    damage.full = 1;
+    Uint64 t = SDL_GetTicksNS();
+    renderFrame(cursor, panel);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("render_full", frames, "frames/s", SDL_GetTicksNS() - t0, s);
+}
+
+//a page per frame from the top to the end, relexing as it goes
+static void bench_scroll(Cursor *cursor, Panel *panel, Samples *s) {
+  int page = TEXT_AREA_HEIGHT / FONT_SIZE;
+  scrollY = 0;
+  cursor_Line = 0;
+  cursor_Pos = 0;
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t line = 0; line < buffer.nlines; line += page) {
+    scrollY = (int)line * FONT_SIZE;
+    Uint64 t = SDL_GetTicksNS();
+    renderFrame(cursor, panel);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("scroll_file", buffer.nlines, "lines/s", SDL_GetTicksNS() - t0, s);
+}
+
+//the same with soft wrap, a frame lays out only the rows it shows
+static void bench_scroll_wrapped(Cursor *cursor, Panel *panel, Samples *s) {
+  int page = TEXT_AREA_HEIGHT / FONT_SIZE;
+  size_t rows;
+  cursor_Line = 0;
+  cursor_Pos = 0;
+  if (view_set_wrap(1) != 0) return;
+  buffer_line_row(&buffer, buffer.nlines, &rows);
+  Uint64 t0 = SDL_GetTicksNS();
+  for (size_t row = 0; row < rows; row += page) {
+    scrollY = (int)row * FONT_SIZE;
+    Uint64 t = SDL_GetTicksNS();
+    renderFrame(cursor, panel);
+    samples_add(s, SDL_GetTicksNS() - t);
+  }
+  report("scroll_wrapped", rows, "rows/s", SDL_GetTicksNS() - t0, s);
+  view_set_wrap(0);
+}
+
+//every event goes through handleInput and gets a frame like in the editor,
+//searches are run to the end so jumps land the same way on every run
+static int bench_replay(const char *recPath, const char *path, const char *logPath, int video, Samples *s) {
+  SDL_IOStream *io = SDL_IOFromFile(recPath, "rb");
+  if (io == NULL || record_begin(io) != 0) {
+    fprintf(stderr, "Not a recording: %s\n", recPath);
+    if (io) SDL_CloseIO(io);
+    return -1;
+  }
+  FILE *log = logPath ? fopen(logPath, "w") : NULL;
+  if (log) fputs("event,at_us,type,key,input_us,render_us\n", log);
+  replaying = 1;
+  bench_open(path);
+  //events apply to the whole file, not to however much was loaded when recorded
+  buffer_wait_lines(&buffer, SIZE_MAX);
+
+  Cursor cursor;
+  Panel panel;
+  if (video) {
+    bench_ui_init(&cursor, &panel);
+    renderFrame(&cursor, &panel);
+  }
+  Samples render = {0};
+  Uint64 inputNs = 0;
+  Uint64 renderNs = 0;
+  RecordedEvent ev = {0};
+  size_t n = 0;
+  int got;
+  while ((got = record_read(io, &ev)) == 1) {
+    Uint64 t0 = SDL_GetTicksNS();
+    replayClipboard = ev.clip;
+    handleInput(&ev.event, renderer);
+    size_t line, pos;
+    if (search_finish(&search, &line, &pos)) {
+      cursor_Line = line;
+      cursor_Pos = pos;
+      scroll_to_cursor();
+    }
+    Uint64 t1 = SDL_GetTicksNS();
+    if (video) renderFrame(&cursor, &panel);
+    Uint64 t2 = SDL_GetTicksNS();
+    samples_add(s, t1 - t0);
+    samples_add(&render, t2 - t1);
+    inputNs += t1 - t0;
+    renderNs += t2 - t1;
+    if (log) {
+      fprintf(log, "%zu,%llu,%u,%u,%.2f,%.2f\n", n, (unsigned long long)(ev.at / 1000), ev.event.type,
+              ev.event.type == SDL_EVENT_KEY_DOWN ? (unsigned)ev.event.key.key : 0,
+              (t1 - t0) / 1000.0, (t2 - t1) / 1000.0);
+    }
+    n++;
+  }
+  if (got < 0) fprintf(stderr, "Recording cut short after %zu events\n", n);
+  report("replay_input", n, "events/s", inputNs, s);
+  if (video) report("replay_render", n, "frames/s", renderNs, &render);
+  printf("\n  ],\"events\":%zu,\"lines\":%zu,\"cursor\":[%zu,%zu],\"hash\":\"%016llx\"",
+         n, buffer.nlines, cursor_Line, cursor_Pos, (unsigned long long)buffer_hash(&buffer));
+  free(render.ns);
+  record_free(&ev);
+  replayClipboard = NULL;
+  if (video) bench_ui_free(&cursor, &panel);
+  if (log) fclose(log);
+  SDL_CloseIO(io);
+  bench_close();
+  replaying = 0;
+  return 0;
+}
+
+//replay a recording headless, the hash of the final text
+static Uint64 check_replay(const char *recPath, const char *path) {
+  SDL_IOStream *io = SDL_IOFromFile(recPath, "rb");
+  if (io == NULL || record_begin(io) != 0) {
+    if (io) SDL_CloseIO(io);
+    return 0;
+  }
+  replaying = 1;
+  bench_open(path);
+  buffer_wait_lines(&buffer, SIZE_MAX);
+  RecordedEvent ev = {0};
+  while (record_read(io, &ev) == 1) {
+    replayClipboard = ev.clip;
+    handleInput(&ev.event, renderer);
+  }
+  Uint64 h = buffer_hash(&buffer);
+  record_free(&ev);
+  replayClipboard = NULL;
+  SDL_CloseIO(io);
+  bench_close();
+  replaying = 0;
+  return h;
+}
+
+static void check_event(Uint64 at, Uint32 type, SDL_Keycode key, SDL_Keymod mod, const char *text) {
+  SDL_Event e;
+  memset(&e, 0, sizeof(e));
+  e.type = type;
+  e.common.timestamp = at;
+  e.key.key = key;
+  e.key.mod = mod;
+  if (type == SDL_EVENT_TEXT_INPUT) e.text.text = text;
+  recorder_event(&recorder, &e);
+}
+
+//records a session that edits, pastes and saves, replays it twice and
+//fails unless the input file is untouched and both runs end on the same
+//text, the clipboard is changed in between so only the recorded one works
+static int bench_check(const char *dir) {
+  char path[512], recPath[512];
+  snprintf(path, sizeof(path), "%s/bench_check.c", dir);
+  snprintf(recPath, sizeof(recPath), "%s/bench_check.rec", dir);
+  if (bench_generate(path, 64 << 10) != 0) return -1;
+  size_t before, after;
+  void *orig = SDL_LoadFile(path, &before);
+  if (orig == NULL || recorder_open(&recorder, recPath) != 0) {
+    SDL_free(orig);
+    return -1;
+  }
+  Uint64 ms = 1000000;
+  check_event(0, SDL_EVENT_TEXT_INPUT, 0, 0, "replayed");
+  check_event(10 * ms, SDL_EVENT_KEY_DOWN, SDLK_RETURN, 0, NULL);
+  check_event(20 * ms, SDL_EVENT_KEY_DOWN, SDLK_S, SDL_KMOD_CTRL, NULL);
+  check_event(3000 * ms, SDL_EVENT_TEXT_INPUT, 0, 0, "after save");
+  check_event(3010 * ms, SDL_EVENT_KEY_DOWN, SDLK_S, SDL_KMOD_CTRL, NULL);
+  SDL_SetClipboardText("recorded\npaste");
+  check_event(3020 * ms, SDL_EVENT_KEY_DOWN, SDLK_V, SDL_KMOD_CTRL, NULL);
+  recorder_close(&recorder);
+  SDL_SetClipboardText("live clipboard");
+
+  Uint64 h0 = check_replay(recPath, path);
+  SDL_SetClipboardText("changed again");
+  Uint64 h1 = check_replay(recPath, path);
+  void *now = SDL_LoadFile(path, &after);
+  int untouched = now && after == before && memcmp(now, orig, before) == 0;
+  int ok = untouched && h0 != 0 && h0 == h1;
+  printf("{\"check\":\"replay\",\"input_untouched\":%s,\"hashes\":[\"%016llx\",\"%016llx\"],\"ok\":%s}\n",
+         untouched ? "true" : "false", (unsigned long long)h0, (unsigned long long)h1, ok ? "true" : "false");
+  SDL_free(orig);
+  SDL_free(now);
+  remove(path);
+  remove(recPath);
+  return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+  size_t sizes[BENCH_MAX_SIZES] = {1, 100, 1024};
+  int nsizes = 3;
+  size_t ops = 100000;
+  size_t frames = 300;
+  size_t paste = 50;
+  size_t ntabs = 200;
+  const char *dir = ".";
+  int keep = 0;
+  const char *replayPath = NULL;
+  const char *filePath = NULL;
+  const char *logPath = NULL;
+  int check = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+      nsizes = 0;
+      for (char *p = argv[++i]; *p && nsizes < BENCH_MAX_SIZES; ) {
+        sizes[nsizes++] = strtoul(p, &p, 10);
+        if (*p == ',') p++;
+      }
+    } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+      ops = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--paste") == 0 && i + 1 < argc) {
+      paste = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--tabs") == 0 && i + 1 < argc) {
+      ntabs = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (strcmp(argv[i], "--keep") == 0) {
+      keep = 1;
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+      filePath = argv[++i];
+    } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+      logPath = argv[++i];
+    } else if (strcmp(argv[i], "--check") == 0) {
+      check = 1;
+    } else {
+      fprintf(stderr, "usage: %s [--sizes 1,100,1024] [--ops N] [--frames N] [--paste MB] [--tabs N] [--dir path] [--keep]\n"
+                      "       %s --replay session.rec --file input [--log events.csv]\n"
+                      "       %s --check [--dir path]\n", argv[0], argv[0], argv[0]);
+      return 1;
+    }
+  }
+  if (nsizes == 0 || (replayPath && filePath == NULL)) return 1;
+
+  simd_init();
+  //no window system needed, fall back to the dummy driver
+  int video = initSDL("offscreen");
+  if (!video) {
+    TTF_Quit();
+    SDL_Quit();
+    video = initSDL("dummy");
+  }
+  if (!video) fprintf(stderr, "No video driver, skipping render workloads\n");
+  loadEventType = SDL_RegisterEvents(1);
+  search_init(&search);
+  status_init(); //handleInput keeps it current even without a window
+  if (video && !createFontAtlas()) video = 0;
+
+  char paths[BENCH_MAX_SIZES][512];
+  Samples s = {0};
+  int failed = 0;
+  if (check) {
+    failed = bench_check(dir) != 0;
+  } else if (replayPath) {
+    printf("{\"simd\":\"%s\",\"workloads\":[", simd.name);
+    if (bench_replay(replayPath, filePath, logPath, video, &s) != 0) printf("\n  ]");
+    printf(",\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+  } else {
+    printf("{\"simd\":\"%s\",\"workloads\":[", simd.name);
+    for (int k = 0; k < nsizes; k++) {
+      snprintf(paths[k], sizeof(paths[k]), "%s/bench_%zumb.c", dir, sizes[k]);
+      if (bench_generate(paths[k], sizes[k] << 20) != 0) return 1;
+      bench_load(paths[k], sizes[k], &s);
+    }
+
+    bench_open(paths[0]);
+    buffer_wait_lines(&buffer, SIZE_MAX);
+    bench_random_edits(ops, &s);
+    bench_newline_edits(ops, &s);
+    if (paste > 0) bench_paste(paste, &s);
+    if (video) {
+      Cursor cursor;
+      Panel panel;
+      bench_ui_init(&cursor, &panel);
+      bench_render(&cursor, &panel, frames, &s);
+      bench_scroll(&cursor, &panel, &s);
+      bench_scroll_wrapped(&cursor, &panel, &s);
+      bench_ui_free(&cursor, &panel);
+    }
+    bench_close();
+    if (ntabs > 0 && bench_tabs(dir, ntabs, keep, &s) != 0) return 1;
+    printf("\n  ],\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+
+    if (!keep) {
+      for (int k = 0; k < nsizes; k++) remove(paths[k]);
+    }
+  }
+  free(s.ns);
+  status_free();
+  search_free(&search);
+  if (video) {
+    SDL_DestroyTexture(fontAtlas);
+    TTF_CloseFont(font);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+  }
+  TTF_Quit();
+  SDL_Quit();
+  return failed;
+}
@@ -0,0 +1,6100 @@
+#include "editor.h"
+
+///////////////////////////////////////////////////////////////
+//globals
+SimdKernels simd;
+int fWidth, fHeight;
+SDL_Window* window = NULL;
+SDL_Renderer* renderer = NULL;
+TTF_Font* font = NULL;
+SDL_Texture* fontAtlas = NULL;
+int scrollX = 0;
+int scrollY = 0;
+SDL_Rect tempRect={ 0, 0, 800, 600};
+int tempS = 41;
+CharInfo fontMap[128]; //ASCII atlas, other codepoints go through glyphCache
+int atlasW = 0, atlasH = 0; //atlas size for texture coords
+int textLength = 0;
+GlyphBatch glyphBatch;
+int frameDrawCalls = 0; //draw calls issued in the current frame
+int frameGlyphs = 0; //glyph quads submitted in the current frame
+GlyphCache glyphCache;
+ColumnCache colCache;
+WrapCache wrapCache;
+FileTabs fileTabs;
+int wrapLines = 0; //the shown buffer is wrapped
+int wrapWanted = 0; //Alt+Z
+size_t undoCap = UNDO_DEFAULT_CAP; //--undo-mb
+int streamForce = 0; //--stream, stream whatever the size
+size_t streamBudget = STREAM_DEFAULT_BUDGET; //--budget MB
+Uint32 loadEventType = 0; //pushed by background loaders and search workers to wake the main loop
+Search search;
+GotoPrompt gotoPrompt;
+String text;
+Buffer buffer;
+size_t cursor_Line=0;
+size_t cursor_Pos=0;
+CustomString cstring;
+CustomString cstats; //draw calls of the last frame
+CustomString cload; //percent of the file indexed, shown while loading
+int countScrollBack = 41;
+int flagScroll=0;
+Damage damage;
+FrameScheduler scheduler;
+Profiler prof;
+Recorder recorder;
+int replaying = 0; //SimpleEditorBench --replay, Ctrl+S leaves the input alone
+const char *replayClipboard = NULL; //clipboard recorded with the Ctrl+V being replayed
+///////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+//tools
+void getWindowGW(int *w) {
+  *w=SCREEN_WIDTH/FONT_SIZE;
+}
+void getWindowGH(int *h) {
+  *h=SCREEN_HEIGHT/FONT_SIZE;
+}
+
+
+// extract int number from int to string rep
+char* getC(int N){
+  int n=N;
+  size_t l;
+  if(n>0){
+    l=log10(abs(n))+1;l++;
+  }
+  else if(n<0){
+    l=log10(abs(n))+1;
+    l++;
+  }
+  else if(n==0){
+    l=2; //"0" and the terminator
+  }
+  //printf("%zu\n",l);
+  char *gNumber=malloc(sizeof(char)*l);
+  if(gNumber==NULL)exit(-1);
+
+  int tempN=snprintf(gNumber,l, "%d", N);
+  //printf("%s\n",gNumber);
+  return gNumber;
+}
+//tools
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//simd kernels
+static size_t count_newlines_scalar(const char *p, size_t n) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += p[i] == '\n';
+  return total;
+}
+
+static const char* find_newline_scalar(const char *p, size_t n) {
+  return memchr(p, '\n', n);
+}
+
+static size_t count_utf8_scalar(const char *p, size_t n) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += (p[i] & 0xC0) != 0x80;
+  return total;
+}
+
+size_t utf8_seq_len(const char *p, size_t n, size_t i) {
+  const unsigned char *s = (const unsigned char*)p + i;
+  size_t left = n - i;
+  unsigned char c = s[0];
+  if (c < 0x80) return 1;
+  if (c >= 0xC2 && c <= 0xDF) {
+    return left >= 2 && (s[1] & 0xC0) == 0x80 ? 2 : 0;
+  }
+  if (c >= 0xE0 && c <= 0xEF) {
+    if (left < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+    if (c == 0xE0 && s[1] < 0xA0) return 0; //overlong
+    if (c == 0xED && s[1] > 0x9F) return 0; //surrogates
+    return 3;
+  }
+  if (c >= 0xF0 && c <= 0xF4) {
+    if (left < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80) return 0;
+    if (c == 0xF0 && s[1] < 0x90) return 0; //overlong
+    if (c == 0xF4 && s[1] > 0x8F) return 0; //past U+10FFFF
+    return 4;
+  }
+  return 0;
+}
+
+//codepoint at i and its length, a malformed byte stands for itself
+static Uint32 utf8_decode(const char *p, size_t n, size_t i, size_t *len) {
+  const unsigned char *s = (const unsigned char*)p + i;
+  size_t k = utf8_seq_len(p, n, i);
+  if (k <= 1) {
+    *len = 1;
+    return s[0];
+  }
+  Uint32 cp = s[0] & (0xFF >> (k + 1));
+  for (size_t j = 1; j < k; j++) cp = (cp << 6) | (s[j] & 0x3F);
+  *len = k;
+  return cp;
+}
+
+//combining marks, variation selectors and emoji modifiers attach to what precedes them
+static int utf8_extends(Uint32 cp) {
+  return (cp >= 0x300 && cp <= 0x36F) || (cp >= 0x1AB0 && cp <= 0x1AFF) ||
+         (cp >= 0x1DC0 && cp <= 0x1DFF) || (cp >= 0x20D0 && cp <= 0x20FF) ||
+         (cp >= 0xFE00 && cp <= 0xFE0F) || (cp >= 0xFE20 && cp <= 0xFE2F) ||
+         (cp >= 0x1F3FB && cp <= 0x1F3FF) || (cp >= 0xE0020 && cp <= 0xE01EF) ||
+         cp == 0x200D;
+}
+
+static int utf8_regional(Uint32 cp) {
+  return cp >= 0x1F1E6 && cp <= 0x1F1FF;
+}
+
+size_t utf8_prev(const char *p, size_t i) {
+  if (i == 0) return 0;
+  size_t from = i - 1;
+  while (from > 0 && i - from < 4 && (p[from] & 0xC0) == 0x80) from--;
+  return utf8_seq_len(p, i, from) == i - from ? from : i - 1;
+}
+
+size_t utf8_next_grapheme(const char *p, size_t n, size_t i) {
+  if (i >= n) return n;
+  if (p[i] == '\r' && i + 1 < n && p[i + 1] == '\n') return i + 2;
+  size_t k;
+  Uint32 cp = utf8_decode(p, n, i, &k);
+  int flag = utf8_regional(cp); //first half of a flag waits for the second
+  i += k;
+  while (i < n) {
+    Uint32 next = utf8_decode(p, n, i, &k);
+    if (cp == 0x200D || utf8_extends(next)) {
+      cp = next;
+    } else if (flag && utf8_regional(next)) {
+      cp = next;
+      flag = 0;
+    } else {
+      break;
+    }
+    i += k;
+  }
+  return i;
+}
+
+//a cluster starts at i whatever comes before, regional indicators are
+//never taken as one since pairing depends on how many precede them
+static int utf8_cluster_start(const char *p, size_t n, size_t i) {
+  if (i == 0) return 1;
+  size_t k;
+  Uint32 cp = utf8_decode(p, n, i, &k);
+  if (utf8_extends(cp) || utf8_regional(cp)) return 0;
+  if (cp == '\n' && p[i - 1] == '\r') return 0;
+  return utf8_decode(p, n, utf8_prev(p, i), &k) != 0x200D;
+}
+
+size_t utf8_prev_grapheme(const char *p, size_t n, size_t i) {
+  if (i == 0) return 0;
+  //back to a sure cluster start, then forward to the last one before i
+  size_t from = utf8_prev(p, i);
+  for (int back = 0; back < 64 && !utf8_cluster_start(p, n, from); back++) from = utf8_prev(p, from);
+  size_t last = from;
+  while (from < i) {
+    last = from;
+    from = utf8_next_grapheme(p, n, from);
+  }
+  return last;
+}
+
+static int validate_utf8_scalar(const char *p, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    size_t k = utf8_seq_len(p, n, i);
+    if (k == 0) return 0;
+    i += k;
+  }
+  return 1;
+}
+
+static const char* find_substr_scalar(const char *p, size_t n, const char *needle, size_t m) {
+  if (m == 0) return p;
+  const char *end = p + n;
+  while ((size_t)(end - p) >= m) {
+    const char *c = memchr(p, needle[0], end - p - m + 1);
+    if (c == NULL) return NULL;
+    if (c[m - 1] == needle[m - 1] && memcmp(c + 1, needle + 1, m - 1) == 0) return c;
+    p = c + 1;
+  }
+  return NULL;
+}
+
+#ifdef SE_HAVE_X86
+//sum the 32 byte counters of acc
+__attribute__((target("avx2")))
+static size_t avx2_sum_bytes(__m256i acc) {
+  __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+  //each 64 bit sum fits its low half, and 32 bit extracts exist on i386 too
+  return (size_t)(Uint32)_mm256_extract_epi32(sums, 0) + (size_t)(Uint32)_mm256_extract_epi32(sums, 2) +
+         (size_t)(Uint32)_mm256_extract_epi32(sums, 4) + (size_t)(Uint32)_mm256_extract_epi32(sums, 6);
+}
+
+__attribute__((target("avx2")))
+static size_t count_newlines_avx2(const char *p, size_t n) {
+  const __m256i nl = _mm256_set1_epi8('\n');
+  size_t i = 0;
+  size_t total = 0;
+  while (i + 32 <= n) {
+    //byte counters would wrap after 255 rounds, fold them before that
+    size_t rounds = (n - i) / 32;
+    if (rounds > 255) rounds = 255;
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t r = 0; r < rounds; r++, i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+      acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, nl));
+    }
+    total += avx2_sum_bytes(acc);
+  }
+  return total + count_newlines_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static const char* find_newline_avx2(const char *p, size_t n) {
+  const __m256i nl = _mm256_set1_epi8('\n');
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+    if (mask) return p + i + __builtin_ctz(mask);
+  }
+  return find_newline_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t count_utf8_avx2(const char *p, size_t n) {
+  //continuation bytes are 0x80..0xBF, as signed bytes everything else is > -65
+  const __m256i limit = _mm256_set1_epi8(-65);
+  size_t i = 0;
+  size_t total = 0;
+  while (i + 32 <= n) {
+    size_t rounds = (n - i) / 32;
+    if (rounds > 255) rounds = 255;
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t r = 0; r < rounds; r++, i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+      acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(v, limit));
+    }
+    total += avx2_sum_bytes(acc);
+  }
+  return total + count_utf8_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int validate_utf8_avx2(const char *p, size_t n) {
+  size_t i = 0;
+  while (i + 32 <= n) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    if (_mm256_movemask_epi8(v) == 0) {
+      i += 32; //all ASCII
+      continue;
+    }
+    //decode sequences through this block, the last one may run past it
+    size_t end = i + 32;
+    while (i < end) {
+      size_t k = utf8_seq_len(p, n, i);
+      if (k == 0) return 0;
+      i += k;
+    }
+  }
+  return validate_utf8_scalar(p + i, n - i);
+}
+
+//compare the first and last needle byte at 32 offsets at once, only
+//offsets where both match are checked in full
+__attribute__((target("avx2")))
+static const char* find_substr_avx2(const char *p, size_t n, const char *needle, size_t m) {
+  if (m < 2) return m ? memchr(p, needle[0], n) : p;
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    __m256i f = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i l = _mm256_loadu_si256((const __m256i*)(p + i + m - 1));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+    while (mask) {
+      size_t k = i + __builtin_ctz(mask);
+      if (memcmp(p + k + 1, needle + 1, m - 2) == 0) return p + k;
+      mask &= mask - 1;
+    }
+  }
+  return find_substr_scalar(p + i, n - i, needle, m);
+}
+#endif
+
+void simd_init(void) {
+  simd.name = "scalar";
+  simd.count_newlines = count_newlines_scalar;
+  simd.find_newline = find_newline_scalar;
+  simd.count_utf8 = count_utf8_scalar;
+  simd.validate_utf8 = validate_utf8_scalar;
+  simd.find_substr = find_substr_scalar;
+#ifdef SE_HAVE_X86
+  if (SDL_HasAVX2()) {
+    simd.name = "avx2";
+    simd.count_newlines = count_newlines_avx2;
+    simd.find_newline = find_newline_avx2;
+    simd.count_utf8 = count_utf8_avx2;
+    simd.validate_utf8 = validate_utf8_avx2;
+    simd.find_substr = find_substr_avx2;
+  }
+#endif
+}
+
+static double bench_gbs(size_t bytes, Uint64 ticks) {
+  double sec = (double)ticks / SDL_GetPerformanceFrequency();
+  return sec > 0 ? bytes / sec / 1e9 : 0;
+}
+
+//best of three runs of every kernel over the same text
+static void simd_bench_set(const SimdKernels *k, const char *text, size_t n) {
+  Uint64 best[5] = {~0ull, ~0ull, ~0ull, ~0ull, ~0ull};
+  size_t lines = 0, found = 0, cps = 0, hits = 0;
+  int valid = 0;
+  for (int run = 0; run < 3; run++) {
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    lines = k->count_newlines(text, n);
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    found = 0;
+    const char *q = text;
+    const char *end = text + n;
+    const char *nl;
+    while (q < end && (nl = k->find_newline(q, end - q)) != NULL) {
+      found++;
+      q = nl + 1;
+    }
+    Uint64 t2 = SDL_GetPerformanceCounter();
+    cps = k->count_utf8(text, n);
+    Uint64 t3 = SDL_GetPerformanceCounter();
+    valid = k->validate_utf8(text, n);
+    Uint64 t4 = SDL_GetPerformanceCounter();
+    hits = 0;
+    q = text;
+    while (q < end && (nl = k->find_substr(q, end - q, "value = c", 9)) != NULL) {
+      hits++;
+      q = nl + 1;
+    }
+    Uint64 t5 = SDL_GetPerformanceCounter();
+    Uint64 t[5] = {t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4};
+    for (int j = 0; j < 5; j++) if (t[j] < best[j]) best[j] = t[j];
+  }
+  printf("%-7s count_newlines %7.2f GB/s (%zu)\n", k->name, bench_gbs(n, best[0]), lines);
+  printf("%-7s find_newline   %7.2f GB/s (%zu)\n", k->name, bench_gbs(n, best[1]), found);
+  printf("%-7s count_utf8     %7.2f GB/s (%zu)\n", k->name, bench_gbs(n, best[2]), cps);
+  printf("%-7s validate_utf8  %7.2f GB/s (%d)\n", k->name, bench_gbs(n, best[3]), valid);
+  printf("%-7s find_substr    %7.2f GB/s (%zu)\n", k->name, bench_gbs(n, best[4]), hits);
+}
+
+void simd_bench(size_t megabytes) {
+  size_t n = megabytes << 20;
+  char *text = malloc(n);
+  if (text == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    return;
+  }
+  //code like lines, every 16th one Cyrillic so UTF-8 paths run too
+  static const char ascii[] = "  int value = compute(x, y); // note\n";
+  static const char utf8[] = "  //\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 text\n";
+  size_t i = 0;
+  unsigned seed = 1;
+  while (i < n) {
+    seed = seed * 1103515245u + 12345u;
+    const char *src = (seed >> 16) % 16 == 0 ? utf8 : ascii;
+    size_t len = strlen(src);
+    if (len > n - i) {
+      memset(text + i, ' ', n - i);
+      break;
+    }
+    memcpy(text + i, src, len);
+    i += len;
+  }
+  printf("simd kernels over %zu MB, active: %s\n", megabytes, simd.name);
+  SimdKernels scalar = {"scalar", count_newlines_scalar, find_newline_scalar, count_utf8_scalar, validate_utf8_scalar, find_substr_scalar};
+  simd_bench_set(&scalar, text, n);
+#ifdef SE_HAVE_X86
+  if (SDL_HasAVX2()) {
+    SimdKernels avx2 = {"avx2", count_newlines_avx2, find_newline_avx2, count_utf8_avx2, validate_utf8_avx2, find_substr_avx2};
+    simd_bench_set(&avx2, text, n);
+  }
+#endif
+  free(text);
+}
+///////////////////////////////////////////////////////////////
+
+void string_init(String *s) {
+  s->length = 0;
+  s->capacity = 16;
+  s->data = malloc(s->capacity);
+  if (s->data == NULL) {
+    fprintf(stderr, "Failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  s->data[0] = '\0';
+}
+
+//grow to hold need bytes plus terminator, doubling like the appenders do
+int string_reserve(String *s, size_t need) {
+  if (need < s->capacity) return 0;
+  if (need < s->length) need = s->length;
+  size_t new_capacity = s->capacity ? s->capacity : 16;
+  while (need >= new_capacity) {
+    new_capacity *= 2;
+  }
+  char *new_data;
+  if (s->capacity == 0 && s->data != NULL) {
+    //view into the loaded file, copy it on first change
+    new_data = malloc(new_capacity);
+    if (new_data == NULL) {
+      return -1;
+    }
+    memcpy(new_data, s->data, s->length);
+    new_data[s->length] = '\0';
+  } else {
+    new_data = realloc(s->data, new_capacity);
+    if (new_data == NULL) {
+      return -1;
+    }
+  }
+  s->data = new_data;
+  s->capacity = new_capacity;
+  return 0;
+}
+
+int string_append_str(String *s, const char *str) {
+  return string_append_len(s, str, strlen(str));
+}
+
+int string_append_len(String *s, const char *str, size_t len) {
+  if (string_reserve(s, s->length + len) != 0) {
+    return -1;
+  }
+  memcpy(s->data + s->length, str, len);
+  s->length += len;
+  s->data[s->length] = '\0';
+  return 0;
+}
+
+int string_append_char(String *s, char c) {
+  if (string_reserve(s, s->length + 1) != 0) {
+    return -1; //error
+  }
+  s->data[s->length++] = c;
+  s->data[s->length] = '\0'; //null terminator
+  return 0;
+}
+
+void string_free(String *s) {
+  if (s->capacity) free(s->data);
+  s->data = NULL;
+  s->length = 0;
+  s->capacity = 0;
+}
+///////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+
+void pool_init(LinePool *p) {
+  memset(p, 0, sizeof(*p));
+}
+
+static void* pool_block(LinePool *p, size_t size) {
+  if (p->nblocks == p->blockCap) {
+    size_t new_cap = p->blockCap ? p->blockCap * 2 : 16;
+    PoolBlock *blocks = realloc(p->blocks, sizeof(PoolBlock) * new_cap);
+    if (blocks == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    p->blocks = blocks;
+    p->blockCap = new_cap;
+  }
+  void *blk = malloc(size);
+  if (blk == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  p->blocks[p->nblocks].base = blk;
+  p->blocks[p->nblocks].size = size;
+  p->nblocks++;
+  p->bytes += size;
+  return blk;
+}
+
+static int pool_class(size_t size) {
+  int c = 0;
+  while (c < POOL_CLASSES && ((size_t)POOL_MIN_CLASS << c) < size) c++;
+  return c;
+}
+
+void* pool_alloc(LinePool *p, size_t size) {
+  int c = pool_class(size);
+  if (c == POOL_CLASSES) {
+    PoolBig *h = malloc(sizeof(PoolBig) + size);
+    if (h == NULL) return NULL;
+    p->bytes += sizeof(PoolBig) + size;
+    h->prev = &p->big;
+    h->next = p->big.next;
+    if (h->next) h->next->prev = h;
+    p->big.next = h;
+    return h + 1;
+  }
+  if (p->freeClass[c]) {
+    void *r = p->freeClass[c];
+    p->freeClass[c] = *(void**)r;
+    return r;
+  }
+  size_t bytes = (size_t)POOL_MIN_CLASS << c;
+  if (p->bumpLeft < bytes) {
+    //the tail of the old block is split down into the free lists
+    for (int k = c - 1; k >= 0; k--) {
+      size_t kb = (size_t)POOL_MIN_CLASS << k;
+      if (p->bumpLeft >= kb) {
+        *(void**)p->bump = p->freeClass[k];
+        p->freeClass[k] = p->bump;
+        p->bump += kb;
+        p->bumpLeft -= kb;
+      }
+    }
+    p->bump = pool_block(p, POOL_BLOCK);
+    p->bumpLeft = POOL_BLOCK;
+  }
+  void *r = p->bump;
+  p->bump += bytes;
+  p->bumpLeft -= bytes;
+  return r;
+}
+
+void pool_release(LinePool *p, void *ptr, size_t size) {
+  if (ptr == NULL) return;
+  int c = pool_class(size);
+  if (c == POOL_CLASSES) {
+    PoolBig *h = (PoolBig*)ptr - 1;
+    h->prev->next = h->next;
+    if (h->next) h->next->prev = h->prev;
+    free(h);
+    p->bytes -= sizeof(PoolBig) + size;
+    return;
+  }
+  *(void**)ptr = p->freeClass[c];
+  p->freeClass[c] = ptr;
+  p->released += (size_t)POOL_MIN_CLASS << c;
+}
+
+//like realloc, old is what was asked for last time
+static void* pool_grow(LinePool *p, void *ptr, size_t old, size_t size, size_t keep) {
+  if (ptr && pool_class(old) == POOL_CLASSES) {
+    //large bodies grow in place when the allocator can
+    PoolBig *h = (PoolBig*)ptr - 1;
+    PoolBig *prev = h->prev;
+    PoolBig *next = h->next;
+    h = realloc(h, sizeof(PoolBig) + size);
+    if (h == NULL) return NULL;
+    prev->next = h;
+    if (next) next->prev = h;
+    p->bytes += size - old;
+    return h + 1;
+  }
+  void *r = pool_alloc(p, size);
+  if (r == NULL) return NULL;
+  if (ptr) {
+    memcpy(r, ptr, keep);
+    pool_release(p, ptr, old);
+  }
+  return r;
+}
+
+void pool_merge(LinePool *dst, LinePool *src) {
+  for (size_t k = 0; k < src->nblocks; k++) {
+    if (dst->nblocks == dst->blockCap) {
+      size_t new_cap = dst->blockCap ? dst->blockCap * 2 : 16;
+      while (new_cap < dst->nblocks + src->nblocks - k) new_cap *= 2;
+      PoolBlock *blocks = realloc(dst->blocks, sizeof(PoolBlock) * new_cap);
+      if (blocks == NULL) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      dst->blocks = blocks;
+      dst->blockCap = new_cap;
+    }
+    dst->blocks[dst->nblocks++] = src->blocks[k];
+  }
+  if (src->big.next) {
+    PoolBig *last = src->big.next;
+    while (last->next) last = last->next;
+    last->next = dst->big.next;
+    if (dst->big.next) dst->big.next->prev = last;
+    dst->big.next = src->big.next;
+    dst->big.next->prev = &dst->big;
+  }
+  dst->bytes += src->bytes;
+  //unused slab and free list space of src is only reclaimed by pool_free
+  free(src->blocks);
+  pool_init(src);
+}
+
+int pool_owns(const LinePool *p, const void *ptr) {
+  for (size_t k = 0; k < p->nblocks; k++) {
+    const PoolBlock *blk = &p->blocks[k];
+    if ((const char*)ptr >= blk->base && (const char*)ptr < blk->base + blk->size) return 1;
+  }
+  return 0;
+}
+
+void pool_free(LinePool *p) {
+  for (size_t k = 0; k < p->nblocks; k++) free(p->blocks[k].base);
+  free(p->blocks);
+  for (PoolBig *h = p->big.next; h != NULL; ) {
+    PoolBig *next = h->next;
+    free(h);
+    h = next;
+  }
+  pool_init(p);
+}
+
+static int pool_block_cmp(const void *a, const void *b) {
+  const char *x = ((const PoolBlock*)a)->base;
+  const char *y = ((const PoolBlock*)b)->base;
+  return x < y ? -1 : x > y;
+}
+
+//block holding ptr, blocks sorted by base
+static PoolBlock* pool_block_of(LinePool *p, const void *ptr) {
+  size_t lo = 0;
+  size_t hi = p->nblocks;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (p->blocks[mid].base <= (const char*)ptr) lo = mid;
+    else hi = mid;
+  }
+  return &p->blocks[lo];
+}
+
+//keep the entries of a free list whose block stays, in order
+static void* pool_filter(LinePool *p, void *head, size_t next_at) {
+  void *keep = NULL;
+  void **tail = &keep;
+  while (head) {
+    void *next = *(void**)((char*)head + next_at);
+    PoolBlock *blk = pool_block_of(p, head);
+    if (blk->freeBytes != blk->size) {
+      *tail = head;
+      tail = (void**)((char*)head + next_at);
+    }
+    head = next;
+  }
+  *tail = NULL;
+  return keep;
+}
+
+void pool_reclaim(LinePool *p) {
+  //walking the free lists costs as much as what is on them, so wait until
+  //a good share of the pool could come back
+  if (p->nblocks == 0 || p->released * 4 < p->bytes) return;
+  p->released = 0;
+  qsort(p->blocks, p->nblocks, sizeof(PoolBlock), pool_block_cmp);
+  for (size_t k = 0; k < p->nblocks; k++) p->blocks[k].freeBytes = 0;
+  //class sizes tile a block exactly, so a block is dead when its free
+  //entries add up to its size
+  for (int c = 0; c < POOL_CLASSES; c++) {
+    for (void *f = p->freeClass[c]; f; f = *(void**)f) {
+      pool_block_of(p, f)->freeBytes += (size_t)POOL_MIN_CLASS << c;
+    }
+  }
+  for (Line *l = p->freeLines; l; l = (Line*)l->text.data) {
+    pool_block_of(p, l)->freeBytes += sizeof(Line);
+  }
+  if (p->bumpLeft) pool_block_of(p, p->bump)->freeBytes += p->bumpLeft;
+  if (p->slabLeft) pool_block_of(p, p->slab)->freeBytes += sizeof(Line) * p->slabLeft;
+  size_t dead = 0;
+  for (size_t k = 0; k < p->nblocks; k++) dead += p->blocks[k].freeBytes == p->blocks[k].size;
+  if (dead == 0) return;
+  for (int c = 0; c < POOL_CLASSES; c++) p->freeClass[c] = pool_filter(p, p->freeClass[c], 0);
+  p->freeLines = pool_filter(p, p->freeLines, offsetof(Line, text.data));
+  if (p->bumpLeft) {
+    PoolBlock *blk = pool_block_of(p, p->bump);
+    if (blk->freeBytes == blk->size) {
+      p->bump = NULL;
+      p->bumpLeft = 0;
+    }
+  }
+  if (p->slabLeft) {
+    PoolBlock *blk = pool_block_of(p, p->slab);
+    if (blk->freeBytes == blk->size) {
+      p->slab = NULL;
+      p->slabLeft = 0;
+    }
+  }
+  size_t kept = 0;
+  for (size_t k = 0; k < p->nblocks; k++) {
+    if (p->blocks[k].freeBytes == p->blocks[k].size) {
+      free(p->blocks[k].base);
+      p->bytes -= p->blocks[k].size;
+    }
+    else p->blocks[kept++] = p->blocks[k];
+  }
+  p->nblocks = kept;
+}
+
+static Line* line_header(LinePool *p) {
+  Line *l;
+  if (p->freeLines) {
+    l = p->freeLines;
+    p->freeLines = (Line*)l->text.data;
+  } else {
+    if (p->slabLeft == 0) {
+      p->slab = pool_block(p, sizeof(Line) * POOL_SLAB_LINES);
+      p->slabLeft = POOL_SLAB_LINES;
+    }
+    l = p->slab++;
+    p->slabLeft--;
+  }
+  l->spans = NULL;
+  l->nspans = 0;
+  l->spanCap = 0;
+  l->lexIn = LEX_NORMAL;
+  l->lexOut = LEX_NORMAL;
+  l->lexDirty = 1;
+  l->bytes = 0;
+  l->chars = 0;
+  l->rows = 0;
+  return l;
+}
+
+Line* line_new(LinePool *p) {
+  Line *l = line_header(p);
+  l->text.length = 0;
+  l->text.capacity = POOL_MIN_CLASS;
+  l->text.data = pool_alloc(p, POOL_MIN_CLASS);
+  l->text.data[0] = '\0';
+  return l;
+}
+
+Line* line_new_view(LinePool *p, const char *data, size_t len) {
+  Line *l = line_header(p);
+  l->text.data = (char*)data;
+  l->text.length = len;
+  l->text.capacity = 0;
+  return l;
+}
+
+void line_free(LinePool *p, Line *l) {
+  if (l == NULL) return;
+  col_forget(l);
+  wrap_forget(l);
+  if (l->text.capacity) pool_release(p, l->text.data, l->text.capacity);
+  pool_release(p, l->spans, sizeof(SynSpan) * l->spanCap);
+  l->text.data = (char*)p->freeLines;
+  p->freeLines = l;
+  p->released += sizeof(Line);
+}
+
+int line_reserve(LinePool *p, String *s, size_t need) {
+  if (need < s->capacity) return 0;
+  if (need < s->length) need = s->length;
+  size_t new_capacity = s->capacity ? s->capacity : 16;
+  while (need >= new_capacity) {
+    new_capacity *= 2;
+  }
+  char *new_data;
+  if (s->capacity == 0 && s->data != NULL) {
+    //view into the loaded file, copy it on first change
+    new_data = pool_alloc(p, new_capacity);
+    if (new_data == NULL) {
+      return -1;
+    }
+    memcpy(new_data, s->data, s->length);
+    new_data[s->length] = '\0';
+  } else {
+    new_data = pool_grow(p, s->data, s->capacity, new_capacity, s->length + 1);
+    if (new_data == NULL) {
+      return -1;
+    }
+  }
+  s->data = new_data;
+  s->capacity = new_capacity;
+  return 0;
+}
+
+int line_append(LinePool *p, String *s, const char *str, size_t len) {
+  if (line_reserve(p, s, s->length + len) != 0) {
+    return -1;
+  }
+  memcpy(s->data + s->length, str, len);
+  s->length += len;
+  s->data[s->length] = '\0';
+  return 0;
+}
+
+void buffer_init(Buffer* b,int flag) {
+  b->nlines = 0;
+  b->capacity = 4; //start
+  b->gapStart = 0;
+  b->currLine = 0;
+  b->totalSizeChars = 0;
+  b->totalBytes = 0;
+  b->stateFlag = flag;
+  b->lexFrom = 0;
+  b->lexTo = 0;
+  b->base = NULL;
+  b->baseSize = 0;
+  b->baseMapped = 0;
+  b->baseFd = -1;
+  b->path = NULL;
+  b->isUtf8 = 1;
+  b->stream = NULL;
+  b->loader = NULL;
+  undo_init(&b->undo, undoCap);
+  pool_init(&b->pool);
+  b->linesLock = NULL;
+  b->damageFrom = SIZE_MAX;
+  b->damageTo = 0;
+  memset(&b->index, 0, sizeof(b->index));
+  b->wrapCols = 0;
+  b->modified = 0;
+  b->saved = 0;
+  b->line = malloc(sizeof(Line*) * b->capacity);
+  if (b->line == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (flag == 0) {
+    //scratch buffer starts with one empty line
+    buffer_insert_line(b, 0, line_new(&b->pool));
+  }
+}
+
+//slot of logical line index
+static size_t buffer_slot(const Buffer *b, size_t index) {
+  return index < b->gapStart ? index : index + (b->capacity - b->nlines);
+}
+
+//slide the gap so it starts at logical index, cost is the distance moved
+static void buffer_move_gap(Buffer *b, size_t index) {
+  size_t gap = b->capacity - b->nlines;
+  if (index < b->gapStart) {
+    size_t count = b->gapStart - index;
+    memmove(b->line + index + gap, b->line + index, sizeof(Line*) * count);
+  } else if (index > b->gapStart) {
+    size_t count = index - b->gapStart;
+    memmove(b->line + b->gapStart, b->line + b->gapStart + gap, sizeof(Line*) * count);
+  }
+  b->gapStart = index;
+}
+
+//make room for extra lines, the part after the gap moves to the new end
+static int buffer_reserve_lines(Buffer *b, size_t extra) {
+  if (b->nlines + extra <= b->capacity) return 0;
+  size_t new_capacity = b->capacity ? b->capacity : 4;
+  while (b->nlines + extra > new_capacity) {
+    new_capacity *= 2;
+  }
+  Line **new_line_array = realloc(b->line, sizeof(Line*) * new_capacity);
+  if (new_line_array == NULL) {
+    return -1;
+  }
+  size_t tail = b->nlines - b->gapStart;
+  memmove(new_line_array + new_capacity - tail,
+          new_line_array + b->capacity - tail, sizeof(Line*) * tail);
+  b->line = new_line_array;
+  b->capacity = new_capacity;
+  return 0;
+}
+
+//line index, see LineIndex
+static void count_add(IndexCount *a, const IndexCount *d) {
+  for (int f = 0; f < INDEX_FIELDS; f++) a->n[f] += d->n[f];
+}
+
+//negative counts wrap, adding them back cancels out
+static void count_sub(IndexCount *a, const IndexCount *d) {
+  for (int f = 0; f < INDEX_FIELDS; f++) a->n[f] -= d->n[f];
+}
+
+static void index_update(LineIndex *x, size_t k, const IndexCount *d) {
+  count_add(&x->blocks[k], d);
+  for (size_t i = k + 1; i <= x->nblocks; i += i & -i) count_add(&x->tree[i], d);
+}
+
+//sum of blocks [0, k)
+static IndexCount index_prefix(const LineIndex *x, size_t k) {
+  IndexCount c = {{0}};
+  for (size_t i = k; i > 0; i -= i & -i) count_add(&c, &x->tree[i]);
+  return c;
+}
+
+static void index_rebuild(LineIndex *x) {
+  for (size_t i = 1; i <= x->nblocks; i++) x->tree[i] = x->blocks[i - 1];
+  for (size_t i = 1; i <= x->nblocks; i++) {
+    size_t j = i + (i & -i);
+    if (j <= x->nblocks) count_add(&x->tree[j], &x->tree[i]);
+  }
+}
+
+//block holding unit value of field, counts of the blocks before it go to
+//before, nblocks when value is past the total
+static size_t index_find(const LineIndex *x, int field, size_t value, IndexCount *before) {
+  size_t k = 0;
+  size_t step = 1;
+  memset(before, 0, sizeof(*before));
+  while (step * 2 <= x->nblocks) step *= 2;
+  for (; step > 0; step /= 2) {
+    if (k + step <= x->nblocks && x->tree[k + step].n[field] <= value) {
+      k += step;
+      value -= x->tree[k].n[field];
+      count_add(before, &x->tree[k]);
+    }
+  }
+  return k;
+}
+
+static void index_reserve(LineIndex *x, size_t need) {
+  if (need <= x->cap) return;
+  size_t new_cap = x->cap ? x->cap : 64;
+  while (new_cap < need) new_cap *= 2;
+  IndexCount *blocks = realloc(x->blocks, sizeof(IndexCount) * new_cap);
+  IndexCount *tree = blocks ? realloc(x->tree, sizeof(IndexCount) * (new_cap + 1)) : NULL;
+  if (blocks) x->blocks = blocks;
+  if (tree == NULL) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  x->tree = tree;
+  x->cap = new_cap;
+}
+
+//new last block, the tree grows by one node in O(log n)
+static void index_append_block(LineIndex *x, const IndexCount *c) {
+  index_reserve(x, x->nblocks + 1);
+  x->blocks[x->nblocks++] = *c;
+  //node i covers blocks (i - lowbit(i), i]
+  size_t i = x->nblocks;
+  IndexCount below = index_prefix(x, i - 1);
+  IndexCount outside = index_prefix(x, i - (i & -i));
+  count_sub(&below, &outside);
+  count_add(&below, c);
+  x->tree[i] = below;
+}
+
+static IndexCount line_count(const Line *l) {
+  IndexCount c = {{1, l->bytes, l->chars, l->rows}};
+  return c;
+}
+
+//rows of l at wrapCols columns each, exact for text of one advance without
+//tabs, the layout measures the rest when the line comes on screen
+static size_t line_rows(const Buffer *b, const Line *l) {
+  if (b->wrapCols == 0) return 1;
+  size_t cols = l->chars;
+  const String *s = &l->text;
+  if (cols > 0 && s->data[s->length - 1] == '\n') cols--;
+  return cols > b->wrapCols ? (cols + b->wrapCols - 1) / b->wrapCols : 1;
+}
+
+//counts of lines [from, to)
+static IndexCount index_sum_lines(const Buffer *b, size_t from, size_t to) {
+  IndexCount c = {{0}};
+  for (size_t i = from; i < to; i++) {
+    IndexCount lc = line_count(buffer_get_line_info(b, i));
+    count_add(&c, &lc);
+  }
+  return c;
+}
+
+//lines [index, index + n) were put into the array, they join the block
+//they land in and an overfull block is cut into even blocks of about
+//INDEX_BLOCK lines, so a paste costs one pass over its lines and at most
+//one rebuild of the tree
+static void index_lines_added(Buffer *b, size_t index, size_t n) {
+  LineIndex *x = &b->index;
+  IndexCount before;
+  if (x->nblocks == 0) {
+    IndexCount zero = {{0}};
+    index_append_block(x, &zero);
+    x->empty++;
+  }
+  //past the last line only the last block can take them, appends skip the search
+  size_t k = index + n == b->nlines ? x->nblocks - 1 : index_find(x, INDEX_LINES, index, &before);
+  size_t old = x->blocks[k].n[INDEX_LINES];
+  if (old == 0) x->empty--;
+  size_t total = old + n;
+  if (total <= 2 * INDEX_BLOCK) {
+    IndexCount c = index_sum_lines(b, index, index + n);
+    index_update(x, k, &c);
+    return;
+  }
+  size_t first = index_prefix(x, k).n[INDEX_LINES];
+  size_t m = total / INDEX_BLOCK;
+  IndexCount neg = {{0}};
+  count_sub(&neg, &x->blocks[k]);
+  if (k + 1 == x->nblocks) {
+    //at the end the tree is extended block by block
+    IndexCount c = index_sum_lines(b, first, first + total / m);
+    count_add(&c, &neg);
+    index_update(x, k, &c);
+    for (size_t j = 1; j < m; j++) {
+      c = index_sum_lines(b, first + total * j / m, first + total * (j + 1) / m);
+      index_append_block(x, &c);
+    }
+    return;
+  }
+  index_reserve(x, x->nblocks + m - 1);
+  memmove(x->blocks + k + m, x->blocks + k + 1, sizeof(IndexCount) * (x->nblocks - k - 1));
+  for (size_t j = 0; j < m; j++) {
+    x->blocks[k + j] = index_sum_lines(b, first + total * j / m, first + total * (j + 1) / m);
+  }
+  x->nblocks += m - 1;
+  index_rebuild(x);
+}
+
+//lines [index, index + n) are about to leave the array
+static void index_lines_removed(Buffer *b, size_t index, size_t n) {
+  LineIndex *x = &b->index;
+  IndexCount before;
+  size_t k = index_find(x, INDEX_LINES, index, &before);
+  size_t end = before.n[INDEX_LINES];
+  size_t at = index;
+  while (at < index + n && k < x->nblocks) {
+    end += x->blocks[k].n[INDEX_LINES];
+    size_t to = end < index + n ? end : index + n;
+    if (to > at) {
+      IndexCount c = index_sum_lines(b, at, to);
+      IndexCount neg = {{0}};
+      count_sub(&neg, &c);
+      index_update(x, k, &neg);
+      if (x->blocks[k].n[INDEX_LINES] == 0) x->empty++;
+      at = to;
+    }
+    k++;
+  }
+  //empty blocks are skipped by lookups, drop them in one pass once they pile up
+  if (x->empty <= x->nblocks / 2) return;
+  size_t kept = 0;
+  for (size_t i = 0; i < x->nblocks; i++) {
+    if (x->blocks[i].n[INDEX_LINES] > 0) x->blocks[kept++] = x->blocks[i];
+  }
+  x->nblocks = kept;
+  x->empty = 0;
+  index_rebuild(x);
+}
+
+static void index_free(LineIndex *x) {
+  free(x->blocks);
+  free(x->tree);
+  memset(x, 0, sizeof(*x));
+}
+
+//difference in the counts of line index goes to its block
+static void buffer_index_line(Buffer *b, size_t index, const IndexCount *d) {
+  LineIndex *x = &b->index;
+  IndexCount before;
+  size_t k = x->nblocks;
+  if (index + 1 == b->nlines && k > 0 && x->blocks[k - 1].n[INDEX_LINES] > 0) k--;
+  else k = index_find(x, INDEX_LINES, index, &before);
+  if (k < x->nblocks) index_update(x, k, d);
+}
+
+//recount line text, the difference goes to the totals and the index
+static void buffer_count_line(Buffer *b, size_t index, Line *l) {
+  size_t bytes = l->text.length;
+  size_t chars = simd.count_utf8(l->text.data, bytes);
+  size_t oldChars = l->chars;
+  size_t oldRows = l->rows;
+  l->chars = chars; //line_rows reads it
+  size_t rows = line_rows(b, l);
+  if (bytes == l->bytes && chars == oldChars && rows == oldRows) return;
+  IndexCount d = {{0, bytes - l->bytes, chars - oldChars, rows - oldRows}};
+  b->totalBytes += d.n[INDEX_BYTES];
+  b->totalSizeChars += d.n[INDEX_CHARS];
+  l->bytes = bytes;
+  l->rows = rows;
+  if (b->stream) return;
+  buffer_index_line(b, index, &d);
+  //wrapped lines below move
+  if (rows != oldRows) buffer_damage(b, index, SIZE_MAX);
+}
+
+void buffer_set_line_rows(Buffer *b, size_t index, size_t rows) {
+  Line *l = buffer_get_line_info(b, index);
+  if (l == NULL || b->stream || l->rows == rows) return;
+  IndexCount d = {{0, 0, 0, rows - l->rows}};
+  l->rows = rows;
+  buffer_index_line(b, index, &d);
+  buffer_damage(b, index, SIZE_MAX);
+}
+
+int buffer_set_wrap(Buffer *b, size_t cols) {
+  if (b->stream) return -1;
+  b->wrapCols = cols;
+  //one pass over the lines block by block, then the tree
+  LineIndex *x = &b->index;
+  size_t i = 0;
+  for (size_t k = 0; k < x->nblocks; k++) {
+    size_t rows = 0;
+    for (size_t end = i + x->blocks[k].n[INDEX_LINES]; i < end; i++) {
+      Line *l = buffer_get_line_info(b, i);
+      l->rows = line_rows(b, l);
+      rows += l->rows;
+    }
+    x->blocks[k].n[INDEX_ROWS] = rows;
+  }
+  index_rebuild(x);
+  buffer_damage(b, 0, SIZE_MAX);
+  return 0;
+}
+
+int buffer_insert_lines(Buffer *b, size_t index, Line **lines, size_t n) {
+  if (index > b->nlines) return -1;
+  if (n == 0) return 0;
+  size_t done = 0;
+  if (b->stream) {
+    while (done < n && stream_insert_line(b->stream, index + done, lines[done]) == 0) done++;
+  } else {
+    if (buffer_reserve_lines(b, n) != 0) return -1;
+    buffer_move_gap(b, index);
+    memcpy(b->line + b->gapStart, lines, sizeof(Line*) * n);
+    b->gapStart += n;
+    done = n;
+  }
+  if (done == 0) return -1;
+  for (size_t k = 0; k < done; k++) {
+    Line *l = lines[k];
+    l->bytes = l->text.length;
+    l->chars = simd.count_utf8(l->text.data, l->text.length);
+    l->rows = line_rows(b, l);
+    b->totalBytes += l->bytes;
+    b->totalSizeChars += l->chars;
+  }
+  b->nlines += done;
+  if (!b->stream) index_lines_added(b, index, done);
+  //keep the highlighter range on the same lines
+  if (b->lexTo >= index && b->lexFrom <= b->lexTo) b->lexTo += done;
+  //new lines are dirty already, the ends widen the range to relex
+  buffer_touch_line(b, index);
+  buffer_touch_line(b, index + done - 1);
+  //lines below moved down
+  buffer_damage(b, index, SIZE_MAX);
+  return done == n ? 0 : -1;
+}
+
+int buffer_insert_line(Buffer *b, size_t index, Line *l) {
+  return buffer_insert_lines(b, index, &l, 1);
+}
+
+//lex range and damage after n lines at index went away
+static void buffer_lines_gone(Buffer *b, size_t index, size_t n) {
+  if (b->lexTo > index) b->lexTo = b->lexTo - index > n ? b->lexTo - n : index;
+  //the following line now starts after a different line, recheck from here
+  if (b->lexFrom > index) b->lexFrom = index;
+  buffer_damage(b, index, SIZE_MAX);
+}
+
+Line* buffer_remove_line(Buffer *b, size_t index) {
+  if (index >= b->nlines) return NULL;
+  Line *l;
+  if (b->stream) {
+    l = stream_remove_line(b->stream, index);
+  } else {
+    index_lines_removed(b, index, 1);
+    buffer_move_gap(b, index + 1);
+    l = b->line[--b->gapStart];
+  }
+  if (l == NULL) return NULL;
+  b->nlines--;
+  b->totalBytes -= l->bytes;
+  b->totalSizeChars -= l->chars;
+  buffer_lines_gone(b, index, 1);
+  return l;
+}
+
+void buffer_remove_lines(Buffer *b, size_t index, size_t n) {
+  if (index >= b->nlines || n == 0) return;
+  if (n > b->nlines - index) n = b->nlines - index;
+  if (b->stream) {
+    for (size_t k = 0; k < n; k++) line_free(&b->pool, buffer_remove_line(b, index));
+    return;
+  }
+  index_lines_removed(b, index, n);
+  //one gap move, the lines end up just below the gap
+  buffer_move_gap(b, index + n);
+  b->gapStart = index;
+  for (size_t k = 0; k < n; k++) {
+    Line *l = b->line[index + k];
+    b->totalBytes -= l->bytes;
+    b->totalSizeChars -= l->chars;
+    line_free(&b->pool, l);
+  }
+  b->nlines -= n;
+  buffer_lines_gone(b, index, n);
+}
+
+void buffer_touch_line(Buffer *b, size_t index) {
+  Line *l = buffer_get_line_info(b, index);
+  if (l == NULL) return;
+  l->lexDirty = 1;
+  col_forget(l);
+  wrap_forget(l);
+  buffer_count_line(b, index, l);
+  buffer_damage(b, index, index);
+  if (b->stream) stream_mark_dirty(b->stream, index);
+  if (b->lexFrom >= b->nlines || b->lexFrom > b->lexTo) {
+    //nothing pending yet
+    if (b->lexFrom > index) b->lexFrom = index;
+    b->lexTo = index;
+  } else {
+    if (b->lexFrom > index) b->lexFrom = index;
+    if (b->lexTo < index) b->lexTo = index;
+  }
+}
+
+void buffer_damage(Buffer *b, size_t from, size_t to) {
+  if (b->damageFrom > b->damageTo) {
+    b->damageFrom = from;
+    b->damageTo = to;
+    return;
+  }
+  if (b->damageFrom > from) b->damageFrom = from;
+  if (b->damageTo < to) b->damageTo = to;
+}
+
+//add string
+void buffer_append_str(Buffer* b, const char* str) {
+  Line *l = line_new(&b->pool);
+  String *s = &l->text;
+  // fill string
+  if (line_append(&b->pool, s, str, strlen(str)) != 0) {
+    fprintf(stderr, "String append failed\n");
+    exit(EXIT_FAILURE);
+  }
+  //grow up if need
+  if (buffer_insert_line(b, b->nlines, l) != 0) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  b->currLine = b->nlines-1;
+}
+
+int buffer_insert_char(Buffer *b, size_t line_index, size_t position, char c) {
+
+  if (line_index >= b->nlines) {
+    return -1; //incorrect index
+  }
+  String *line = buffer_get_line(b, line_index);
+
+  if (position > line->length) {
+    return -1; //incorrect position
+  }
+  //cursor may sit after the line break, text still goes in front of it
+  if (position == line->length && position > 0 && line->data[position - 1] == '\n') {
+    position--;
+  }
+
+  if (c == '\n') {
+    //split string
+    //create string
+    Line *new_line = line_new(&b->pool);
+
+    //after position
+    if (line_append(&b->pool, &new_line->text, line->data + position, line->length - position) != 0 ||
+        line_reserve(&b->pool, line, position + 1) != 0) {
+      line_free(&b->pool, new_line);
+      return -1;
+    }
+
+    //add string after pos
+    if (buffer_insert_line(b, line_index + 1, new_line) != 0) {
+      line_free(&b->pool, new_line);
+      return -1;
+    }
+
+    //cutting string
+    line->data[position] = '\n';
+    line->data[position+1] = '\0';
+    line->length = position+1;
+    b->currLine = line_index + 1;
+    buffer_touch_line(b, line_index);
+
+    return 0;
+  } else {
+    //add char
+    //increase string if need
+    if (line_reserve(&b->pool, line, line->length + 1) != 0) return -1;
+    //move if need
+    memmove(line->data + position + 1, line->data + position, line->length - position + 1);
+    line->data[position] = c;
+    line->length++;
+    buffer_touch_line(b, line_index);
+    return 0;
+  }
+}
+
+void buffer_backspace_test(Buffer *b,int cursor_Line,int cursor_Pos) {
+  if (cursor_Line < 0 || (size_t)cursor_Line >= b->nlines) return;
+  String *line = buffer_get_line(b, cursor_Line);
+  if (cursor_Pos <= 0 || (size_t)cursor_Pos > line->length) return;
+  if (line_reserve(&b->pool, line, line->length) != 0) return; //own the bytes first
+
+  if (line->data[cursor_Pos - 1] == '\n') {
+    // printf("delete new line\n");
+    memmove(line->data + (cursor_Pos - 1),
+            line->data + cursor_Pos,
+            line->length - cursor_Pos + 1);
+    line->length--;
+    if ((size_t)cursor_Line + 1 < b->nlines) {
+      String *nextLine = buffer_get_line(b, cursor_Line + 1);
+
+      //join, the line is grown by doubling so repeated joins stay amortized
+      if (line_append(&b->pool, line, nextLine->data, nextLine->length) != 0) {
+        //error realloc, keep next line as is
+        buffer_touch_line(b, cursor_Line);
+        return;
+      }
+
+      //delete
+      line_free(&b->pool, buffer_remove_line(b, cursor_Line + 1));
+    }
+    buffer_touch_line(b, cursor_Line);
+  } else {
+    //printf("DEL\n");
+    memmove(line->data + (cursor_Pos - 1),
+            line->data + cursor_Pos,
+            line->length - cursor_Pos + 1);
+    line->length--;
+    buffer_touch_line(b, cursor_Line);
+  }
+}
+
+
+int buffer_insert_str(Buffer *b, size_t line_index, size_t position, const char *s, size_t len) {
+  if (line_index >= b->nlines) return -1;
+  String *line = buffer_get_line(b, line_index);
+  if (position > line->length) return -1;
+  if (len == 0) return 0;
+  size_t nnl = simd.count_newlines(s, len);
+  if (nnl == 0) {
+    if (line_reserve(&b->pool, line, line->length + len) != 0) return -1;
+    memmove(line->data + position + len, line->data + position, line->length - position + 1);
+    memcpy(line->data + position, s, len);
+    line->length += len;
+  } else {
+    //text up to the first newline stays on this line, the rest becomes
+    //new lines and the old tail ends up behind the last of them
+    const char *first = simd.find_newline(s, len) + 1;
+    const char *last = s + len;
+    while (last[-1] != '\n') last--;
+    Line *tail = line_new(&b->pool);
+    if (line_append(&b->pool, &tail->text, last, s + len - last) != 0 ||
+        line_append(&b->pool, &tail->text, line->data + position, line->length - position) != 0 ||
+        line_reserve(&b->pool, line, position + (first - s)) != 0) {
+      line_free(&b->pool, tail);
+      return -1;
+    }
+    memcpy(line->data + position, s, first - s);
+    line->length = position + (first - s);
+    line->data[line->length] = '\0';
+    //all new lines go in with one gap move and one index update
+    Line *few[16];
+    Line **lines = nnl <= 16 ? few : malloc(sizeof(Line*) * nnl);
+    if (lines == NULL) {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    for (const char *p = first; p < last; ) {
+      const char *e = simd.find_newline(p, last - p) + 1;
+      Line *l = line_new(&b->pool);
+      if (line_append(&b->pool, &l->text, p, e - p) != 0) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      lines[n++] = l;
+      p = e;
+    }
+    lines[n++] = tail;
+    if (buffer_insert_lines(b, line_index + 1, lines, n) != 0) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    if (lines != few) free(lines);
+  }
+  buffer_touch_line(b, line_index);
+  return 0;
+}
+
+int buffer_delete_range(Buffer *b, size_t line_index, size_t position, size_t len) {
+  if (line_index >= b->nlines) return -1;
+  String *line = buffer_get_line(b, line_index);
+  if (position > line->length) return -1;
+  if (len == 0) return 0;
+  //past the line break is the start of the next line
+  if (position == line->length && line_index + 1 < b->nlines) {
+    line = buffer_get_line(b, ++line_index);
+    position = 0;
+  }
+  if (line_reserve(&b->pool, line, line->length) != 0) return -1; //own the bytes first
+  size_t cut = line->length - position < len ? line->length - position : len;
+  //taking the line break joins the next line in
+  int join = cut > 0 && position + cut == line->length && line->data[line->length - 1] == '\n';
+  memmove(line->data + position, line->data + position + cut, line->length - position - cut + 1);
+  line->length -= cut;
+  size_t rem = len - cut;
+  //whole lines go together, no bytes move
+  size_t whole = 0;
+  while (join && line_index + 1 + whole < b->nlines) {
+    String *next = buffer_get_line(b, line_index + 1 + whole);
+    if (rem < next->length) break;
+    rem -= next->length;
+    join = next->length > 0 && next->data[next->length - 1] == '\n';
+    whole++;
+  }
+  buffer_remove_lines(b, line_index + 1, whole);
+  //the rest of the line after them joins this one
+  if (join && line_index + 1 < b->nlines) {
+    String *next = buffer_get_line(b, line_index + 1);
+    if (line_append(&b->pool, line, next->data + rem, next->length - rem) != 0) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    rem = 0;
+    buffer_remove_lines(b, line_index + 1, 1);
+  }
+  buffer_touch_line(b, line_index);
+  return rem == 0 ? 0 : -1;
+}
+
+size_t buffer_copy_range(const Buffer *b, size_t line_index, size_t position, size_t len, char *dst) {
+  size_t done = 0;
+  while (done < len && line_index < b->nlines) {
+    const String *line = buffer_get_line(b, line_index++);
+    if (position > line->length) break;
+    size_t n = line->length - position < len - done ? line->length - position : len - done;
+    memcpy(dst + done, line->data + position, n);
+    done += n;
+    position = 0;
+  }
+  return done;
+}
+
+
+void buffer_load_view(Buffer *b, char *data, size_t size, int mapped) {
+  b->base = data;
+  b->baseSize = size;
+  b->baseMapped = mapped;
+  b->isUtf8 = simd.validate_utf8(data, size);
+  if (!b->isUtf8) SDL_Log("File is not valid UTF-8, editing bytes");
+  //one growth of the line array for the whole file
+  if (buffer_reserve_lines(b, simd.count_newlines(data, size) + 1) != 0) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  Line *batch[1024];
+  size_t n = 0;
+  const char *p = data;
+  const char *end = data + size;
+  while (p < end) {
+    const char *nl = simd.find_newline(p, end - p);
+    const char *e = nl ? nl + 1 : end;
+    batch[n++] = line_new_view(&b->pool, p, e - p);
+    p = e;
+    if (n == SDL_arraysize(batch) || p == end) {
+      if (buffer_insert_lines(b, b->nlines, batch, n) != 0) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      n = 0;
+    }
+  }
+  b->currLine = b->nlines ? b->nlines - 1 : 0;
+}
+
+//hand a batch of lines to the main thread, batches end on a newline so
+//UTF-8 checks per batch give the same answer as one over the whole file
+static void loader_publish(BufferLoader *ld, Line **batch, size_t n, const char *from, const char *to) {
+  int valid = simd.validate_utf8(from, to - from);
+  SDL_LockMutex(ld->lock);
+  if (ld->nready + n > ld->readyCap) {
+    size_t new_cap = ld->readyCap ? ld->readyCap : LOADER_BATCH;
+    while (new_cap < ld->nready + n) new_cap *= 2;
+    Line **r = realloc(ld->ready, sizeof(Line*) * new_cap);
+    if (r == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    ld->ready = r;
+    ld->readyCap = new_cap;
+  }
+  memcpy(ld->ready + ld->nready, batch, sizeof(Line*) * n);
+  ld->nready += n;
+  ld->loaded = to - ld->data;
+  ld->isUtf8 &= valid;
+  SDL_BroadcastCondition(ld->progress);
+  SDL_UnlockMutex(ld->lock);
+  SDL_Event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.type = loadEventType;
+  SDL_PushEvent(&ev);
+}
+
+static int loader_run(void *data) {
+  BufferLoader *ld = data;
+  Line **batch = malloc(sizeof(Line*) * LOADER_BATCH);
+  if (batch == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t want = LOADER_FIRST_BATCH;
+  size_t n = 0;
+  const char *p = ld->data;
+  const char *from = p;
+  const char *end = ld->data + ld->size;
+  while (p < end && !SDL_GetAtomicInt(&ld->stop)) {
+    const char *nl = simd.find_newline(p, end - p);
+    const char *e = nl ? nl + 1 : end;
+    batch[n++] = line_new_view(&ld->pool, p, e - p);
+    p = e;
+    if (n == want || p == end) {
+      loader_publish(ld, batch, n, from, p);
+      from = p;
+      n = 0;
+      want = LOADER_BATCH;
+    }
+  }
+  //lines of a stopped load go with the loader's pool
+  free(batch);
+#ifdef SE_HAVE_MMAP
+  if (ld->mapped) madvise((void*)ld->data, ld->size, MADV_NORMAL);
+#endif
+  SDL_LockMutex(ld->lock);
+  ld->done = 1;
+  SDL_BroadcastCondition(ld->progress);
+  SDL_UnlockMutex(ld->lock);
+  SDL_Event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.type = loadEventType;
+  SDL_PushEvent(&ev);
+  return 0;
+}
+
+//lines the worker made are handed to into, picked up or not
+static void loader_free(BufferLoader *ld, LinePool *into) {
+  if (ld->thread) {
+    SDL_SetAtomicInt(&ld->stop, 1);
+    SDL_WaitThread(ld->thread, NULL);
+  }
+  pool_merge(into, &ld->pool);
+  free(ld->ready);
+  if (ld->progress) SDL_DestroyCondition(ld->progress);
+  if (ld->lock) SDL_DestroyMutex(ld->lock);
+  free(ld);
+}
+
+int buffer_load_async(Buffer *b, char *data, size_t size, int mapped) {
+  BufferLoader *ld = calloc(1, sizeof(BufferLoader));
+  if (ld == NULL) return -1;
+  ld->data = data;
+  ld->size = size;
+  ld->mapped = mapped;
+  ld->isUtf8 = 1;
+  ld->lock = SDL_CreateMutex();
+  ld->progress = SDL_CreateCondition();
+  if (ld->lock == NULL || ld->progress == NULL) {
+    loader_free(ld, &b->pool);
+    return -1;
+  }
+  //the buffer owns the bytes from here, the worker only reads them
+  b->base = data;
+  b->baseSize = size;
+  b->baseMapped = mapped;
+  b->loader = ld;
+  ld->thread = SDL_CreateThread(loader_run, "buffer_load", ld);
+  if (ld->thread == NULL) {
+    b->loader = NULL;
+    b->base = NULL;
+    loader_free(ld, &b->pool);
+    return -1;
+  }
+  return 0;
+}
+
+int buffer_poll_load(Buffer *b) {
+  BufferLoader *ld = b->loader;
+  if (ld == NULL) return 0;
+  SDL_LockMutex(ld->lock);
+  Line **ready = ld->ready;
+  size_t n = ld->nready;
+  int done = ld->done;
+  ld->ready = NULL;
+  ld->nready = 0;
+  ld->readyCap = 0;
+  SDL_UnlockMutex(ld->lock);
+
+  //published lines are whole, they always go after everything loaded so far
+  if (b->linesLock) SDL_LockRWLockForWriting(b->linesLock);
+  if (buffer_insert_lines(b, b->nlines, ready, n) != 0 && n > 0) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  if (b->linesLock) SDL_UnlockRWLock(b->linesLock);
+  free(ready);
+
+  if (done) {
+    SDL_WaitThread(ld->thread, NULL);
+    ld->thread = NULL;
+    b->isUtf8 = ld->isUtf8;
+    if (!b->isUtf8) SDL_Log("File is not valid UTF-8, editing bytes");
+    loader_free(ld, &b->pool);
+    b->loader = NULL;
+    //always leave a line for the cursor
+    if (b->nlines == 0) {
+      buffer_insert_line(b, 0, line_new(&b->pool));
+      n++;
+    }
+  }
+  return n > 0;
+}
+
+void buffer_wait_lines(Buffer *b, size_t n) {
+  while (b->nlines < n && b->loader) {
+    BufferLoader *ld = b->loader;
+    SDL_LockMutex(ld->lock);
+    while (ld->nready == 0 && !ld->done) SDL_WaitCondition(ld->progress, ld->lock);
+    SDL_UnlockMutex(ld->lock);
+    buffer_poll_load(b);
+  }
+  while (b->nlines < n && b->stream) {
+    StreamFile *s = b->stream;
+    SDL_LockMutex(s->lock);
+    while (s->nfound == 0 && !SDL_GetAtomicInt(&s->done)) {
+      SDL_WaitCondition(s->progress, s->lock);
+    }
+    int done = SDL_GetAtomicInt(&s->done) && s->nfound == 0;
+    SDL_UnlockMutex(s->lock);
+    stream_poll(b);
+    if (done) break;
+  }
+}
+
+int buffer_load_progress(const Buffer *b) {
+  size_t loaded = 0;
+  size_t size = 0;
+  if (b->loader) {
+    SDL_LockMutex(b->loader->lock);
+    loaded = b->loader->loaded;
+    SDL_UnlockMutex(b->loader->lock);
+    size = b->loader->size;
+  } else if (b->stream && !SDL_GetAtomicInt(&b->stream->done)) {
+    SDL_LockMutex(b->stream->lock);
+    loaded = b->stream->scanned;
+    SDL_UnlockMutex(b->stream->lock);
+    size = b->stream->fileSize;
+  } else {
+    return 100;
+  }
+  return size ? (int)((Uint64)loaded * 100 / size) : 100;
+}
+
+#ifdef SE_HAVE_MMAP
+#define SAVE_IOV 1024 //iovecs per writev
+#define SAVE_COPY_MIN (64 << 10) //shorter unedited runs go through writev
+
+//lines are queued as iovecs straight from their storage, unedited runs of
+//the original file are copied by the kernel
+typedef struct {
+  int fd;
+  struct iovec iov[SAVE_IOV];
+  int niov;
+  Uint64 written;
+} SaveWriter;
+
+static int save_flush(SaveWriter *w) {
+  int i = 0;
+  while (i < w->niov) {
+    ssize_t n = writev(w->fd, w->iov + i, w->niov - i);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    w->written += n;
+    //a short write stops inside an iovec, resume from there
+    while (i < w->niov && (size_t)n >= w->iov[i].iov_len) n -= w->iov[i++].iov_len;
+    if (i < w->niov) {
+      w->iov[i].iov_base = (char*)w->iov[i].iov_base + n;
+      w->iov[i].iov_len -= n;
+    }
+  }
+  w->niov = 0;
+  return 0;
+}
+
+static int save_bytes(SaveWriter *w, const char *p, size_t len) {
+  if (len == 0) return 0;
+  //lines next to each other in memory go out as one iovec
+  if (w->niov > 0) {
+    struct iovec *last = &w->iov[w->niov - 1];
+    if ((const char*)last->iov_base + last->iov_len == p) {
+      last->iov_len += len;
+      return 0;
+    }
+  }
+  if (w->niov == SAVE_IOV && save_flush(w) != 0) return -1;
+  w->iov[w->niov].iov_base = (void*)p;
+  w->iov[w->niov].iov_len = len;
+  w->niov++;
+  return 0;
+}
+
+//len bytes at off of in, copy_file_range where the kernel can, pread otherwise
+static int save_copy(SaveWriter *w, int in, Uint64 off, Uint64 len) {
+  if (save_flush(w) != 0) return -1;
+#ifdef SE_HAVE_COPY_RANGE
+  while (len > 0) {
+    loff_t from = off;
+    ssize_t n = copy_file_range(in, &from, w->fd, NULL, len, 0);
+    if (n <= 0) break; //EXDEV, ENOSYS and friends fall through to pread
+    off += n;
+    len -= n;
+    w->written += n;
+  }
+#endif
+  char *chunk = len > 0 ? malloc(READ_CHUNK) : NULL;
+  if (len > 0 && chunk == NULL) return -1;
+  while (len > 0) {
+    ssize_t n = pread(in, chunk, len < READ_CHUNK ? len : READ_CHUNK, off);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      free(chunk);
+      return -1;
+    }
+    w->iov[0].iov_base = chunk;
+    w->iov[0].iov_len = n;
+    w->niov = 1;
+    if (save_flush(w) != 0) {
+      free(chunk);
+      return -1;
+    }
+    off += n;
+    len -= n;
+  }
+  free(chunk);
+  return 0;
+}
+
+//a pending run of unedited bytes of base
+static int save_run(SaveWriter *w, const Buffer *b, Uint64 off, Uint64 len) {
+  if (len == 0) return 0;
+  if (b->baseFd >= 0 && len >= SAVE_COPY_MIN) return save_copy(w, b->baseFd, off, len);
+  return save_bytes(w, b->base + off, len);
+}
+
+static int save_lines(SaveWriter *w, const Buffer *b) {
+  Uint64 runOff = 0;
+  Uint64 runLen = 0;
+  for (size_t i = 0; i < b->nlines; i++) {
+    const String *t = &buffer_get_line_info(b, i)->text;
+    if (t->length == 0) continue;
+    if (t->capacity == 0 && t->data >= b->base && t->data < b->base + b->baseSize) {
+      //still a view of the file, extend the run while lines stay in order
+      Uint64 off = t->data - b->base;
+      if (runLen > 0 && runOff + runLen == off) {
+        runLen += t->length;
+        continue;
+      }
+      if (save_run(w, b, runOff, runLen) != 0) return -1;
+      runOff = off;
+      runLen = t->length;
+    } else {
+      if (save_run(w, b, runOff, runLen) != 0) return -1;
+      runLen = 0;
+      if (save_bytes(w, t->data, t->length) != 0) return -1;
+    }
+  }
+  return save_run(w, b, runOff, runLen);
+}
+
+//clean pages are ranges of the original file, only dirty pages are written
+static int save_stream(SaveWriter *w, StreamFile *s) {
+  Uint64 runOff = 0;
+  Uint64 runLen = 0;
+  for (size_t k = 0; k < s->npages; k++) {
+    StreamPage *pg = &s->pages[k];
+    if (!pg->dirty) {
+      if (runLen > 0 && runOff + runLen == pg->offset) {
+        runLen += pg->size;
+        continue;
+      }
+      if (runLen > 0 && save_copy(w, s->fd, runOff, runLen) != 0) return -1;
+      runOff = pg->offset;
+      runLen = pg->size;
+      continue;
+    }
+    if (runLen > 0 && save_copy(w, s->fd, runOff, runLen) != 0) return -1;
+    runLen = 0;
+    for (Uint32 i = 0; i < pg->nlines; i++) {
+      if (save_bytes(w, pg->lines[i]->text.data, pg->lines[i]->text.length) != 0) return -1;
+    }
+  }
+  if (runLen > 0 && save_copy(w, s->fd, runOff, runLen) != 0) return -1;
+  return 0;
+}
+
+int buffer_save(Buffer *b, const char *path) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  //everything has to be indexed, a running load or scan is waited for
+  buffer_wait_lines(b, (size_t)-1);
+  size_t plen = strlen(path);
+  char *tmp = malloc(plen + sizeof(".XXXXXX"));
+  if (tmp == NULL) return -1;
+  memcpy(tmp, path, plen);
+  memcpy(tmp + plen, ".XXXXXX", sizeof(".XXXXXX"));
+  SaveWriter *w = malloc(sizeof(SaveWriter));
+  int fd = w ? mkstemp(tmp) : -1;
+  if (fd < 0) {
+    SDL_Log("Save failed, cannot create %s: %s", tmp, strerror(errno));
+    free(w);
+    free(tmp);
+    return -1;
+  }
+  //keep the permissions of the file being replaced
+  struct stat st;
+  fchmod(fd, stat(path, &st) == 0 ? (st.st_mode & 07777) : 0644);
+  w->fd = fd;
+  w->niov = 0;
+  w->written = 0;
+  int err = b->stream ? save_stream(w, b->stream) : save_lines(w, b);
+  if (err == 0) err = save_flush(w);
+  if (err == 0) err = fsync(fd);
+  if (close(fd) != 0) err = -1;
+  if (err == 0) err = rename(tmp, path);
+  if (err != 0) {
+    SDL_Log("Save of %s failed: %s", path, strerror(errno));
+    unlink(tmp);
+  } else {
+    //make the rename itself durable
+    const char *slash = strrchr(path, '/');
+    char *dir = slash ? tmp : ".";
+    if (slash) {
+      memcpy(tmp, path, slash - path + 1);
+      tmp[slash - path + 1] = '\0';
+    }
+    int dfd = open(dir, O_RDONLY);
+    if (dfd >= 0) {
+      fsync(dfd);
+      close(dfd);
+    }
+    b->modified = 0;
+    b->saved = 1;
+    Uint64 end = SDL_GetPerformanceCounter();
+    SDL_Log("Saved %s, %llu bytes in %.1f ms", path, (unsigned long long)w->written,
+            (double)(1000 * (end - start)) / SDL_GetPerformanceFrequency());
+  }
+  free(w);
+  free(tmp);
+  return err == 0 ? 0 : -1;
+}
+#else
+int buffer_save(Buffer *b, const char *path) {
+  (void)b;
+  SDL_Log("Saving %s is not supported on this platform", path);
+  return -1;
+}
+#endif
+
+String* buffer_get_line(const Buffer* b, size_t index) {
+  Line *l = buffer_get_line_info(b, index);
+  return l ? &l->text : NULL;
+}
+
+Line* buffer_get_line_info(const Buffer* b, size_t index) {
+  if (index >= b->nlines) return NULL;
+  if (b->stream) return stream_line(b->stream, index);
+  return b->line[buffer_slot(b, index)];
+}
+
+//counts of the lines in front of line
+static IndexCount buffer_count_before(const Buffer *b, size_t line) {
+  if (line > b->nlines) line = b->nlines;
+  IndexCount before;
+  size_t k = index_find(&b->index, INDEX_LINES, line, &before);
+  if (k == b->index.nblocks) return before;
+  //lines of the block in front of line
+  for (size_t i = before.n[INDEX_LINES]; i < line; i++) {
+    IndexCount lc = line_count(buffer_get_line_info(b, i));
+    count_add(&before, &lc);
+  }
+  return before;
+}
+
+int buffer_line_offset(const Buffer *b, size_t line, size_t *bytes, size_t *chars) {
+  if (b->stream) return -1;
+  IndexCount before = buffer_count_before(b, line);
+  *bytes = before.n[INDEX_BYTES];
+  if (chars) *chars = before.n[INDEX_CHARS];
+  return 0;
+}
+
+int buffer_line_row(const Buffer *b, size_t line, size_t *row) {
+  if (b->stream) return -1;
+  *row = buffer_count_before(b, line).n[INDEX_ROWS];
+  return 0;
+}
+
+//line holding unit offset of field, the rest of offset is left in *rem
+static int buffer_find_offset(const Buffer *b, int field, size_t offset, size_t *line, size_t *rem) {
+  if (b->stream || b->nlines == 0) return -1;
+  IndexCount before;
+  size_t k = index_find(&b->index, field, offset, &before);
+  if (k == b->index.nblocks) {
+    //past the end, cursor goes behind the last character
+    *line = b->nlines - 1;
+    *rem = SIZE_MAX;
+    return 0;
+  }
+  offset -= before.n[field];
+  size_t i = before.n[INDEX_LINES];
+  for (;;) {
+    IndexCount lc = line_count(buffer_get_line_info(b, i));
+    if (offset < lc.n[field]) break;
+    offset -= lc.n[field];
+    i++;
+  }
+  *line = i;
+  *rem = offset;
+  return 0;
+}
+
+int buffer_offset_line(const Buffer *b, size_t offset, size_t *line, size_t *pos) {
+  size_t rem;
+  if (buffer_find_offset(b, INDEX_BYTES, offset, line, &rem) != 0) return -1;
+  const String *s = buffer_get_line(b, *line);
+  //never leave the cursor inside a multibyte sequence or a cluster
+  *pos = rem < s->length ? utf8_prev_grapheme(s->data, s->length, rem + 1) : s->length;
+  return 0;
+}
+
+int buffer_row_line(const Buffer *b, size_t row, size_t *line, size_t *rowInLine) {
+  size_t rem;
+  if (buffer_find_offset(b, INDEX_ROWS, row, line, &rem) != 0) return -1;
+  size_t rows = buffer_get_line_info(b, *line)->rows;
+  *rowInLine = rem < rows ? rem : rows - 1;
+  return 0;
+}
+
+void buffer_print(const Buffer* b) {
+  for (size_t i = 0; i < b->nlines; i++) {
+    String *s = buffer_get_line(b, i);
+    printf("%.*s\n", (int)s->length, s->data);
+  }
+  printf("Total chars: %zu\n", b->totalSizeChars);
+}
+
+//free buffer
+void buffer_free(Buffer* b) {
+  //the worker reads base, stop it before anything goes away
+  if (b->loader) {
+    loader_free(b->loader, &b->pool);
+    b->loader = NULL;
+  }
+  if (b->stream) {
+    stream_close(b->stream);
+    b->stream = NULL;
+  }
+  //headers, bodies and spans of every line, parked tabs share the caches
+  //with the shown buffer so only this pool's entries go
+  col_forget_pool(&b->pool);
+  wrap_forget_pool(&b->pool);
+  pool_free(&b->pool);
+  free(b->line);
+  if (b->base != NULL) {
+#ifdef SE_HAVE_MMAP
+    if (b->baseMapped) munmap(b->base, b->baseSize);
+    else
+#endif
+      free(b->base);
+  }
+#ifdef SE_HAVE_MMAP
+  if (b->baseFd >= 0) close(b->baseFd);
+#endif
+  free(b->path);
+  undo_free(&b->undo);
+  if (b->linesLock) SDL_DestroyRWLock(b->linesLock);
+  b->linesLock = NULL;
+  b->path = NULL;
+  b->baseFd = -1;
+  b->base = NULL;
+  b->baseSize = 0;
+  b->baseMapped = 0;
+  b->line = NULL;
+  b->nlines = 0;
+  b->capacity = 0;
+  b->gapStart = 0;
+  b->currLine = 0;
+  b->totalSizeChars = 0;
+  b->totalBytes = 0;
+  index_free(&b->index);
+  b->wrapCols = 0;
+  b->modified = 0;
+  b->saved = 0;
+  b->lexFrom = 0;
+  b->lexTo = 0;
+  b->damageFrom = SIZE_MAX;
+  b->damageTo = 0;
+}
+
+//////////////////////////////////////////////////////////////
+//undo
+void undo_init(UndoLog *u, size_t cap) {
+  memset(u, 0, sizeof(*u));
+  u->cap = cap;
+  u->sealed = 1;
+}
+
+void undo_free(UndoLog *u) {
+  free(u->arena);
+  free(u->ops);
+  undo_init(u, u->cap);
+}
+
+void undo_seal(UndoLog *u) {
+  u->sealed = 1;
+}
+
+//make room for len more bytes, dropping the oldest ops until the log is
+//back under three quarters of its cap
+static void undo_trim(UndoLog *u, size_t len) {
+  size_t keep = u->used + u->nops * sizeof(UndoOp);
+  if (keep + len + sizeof(UndoOp) <= u->cap) return;
+  size_t k = 0;
+  while (k < u->nops && keep + len + sizeof(UndoOp) > u->cap / 4 * 3) {
+    keep -= u->ops[k].len + sizeof(UndoOp);
+    k++;
+  }
+  size_t shift = k < u->nops ? u->ops[k].at : u->used;
+  memmove(u->arena, u->arena + shift, u->used - shift);
+  memmove(u->ops, u->ops + k, sizeof(UndoOp) * (u->nops - k));
+  u->used -= shift;
+  u->nops -= k;
+  u->applied = u->applied > k ? u->applied - k : 0;
+  for (size_t i = 0; i < u->nops; i++) u->ops[i].at -= shift;
+}
+
+static void undo_grow(UndoLog *u, size_t len) {
+  if (u->used + len > u->arenaCap) {
+    size_t new_cap = u->arenaCap ? u->arenaCap : 4096;
+    while (u->used + len > new_cap) new_cap *= 2;
+    char *a = realloc(u->arena, new_cap);
+    if (a == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    u->arena = a;
+    u->arenaCap = new_cap;
+  }
+  if (u->nops == u->opsCap) {
+    size_t new_cap = u->opsCap ? u->opsCap * 2 : 64;
+    UndoOp *o = realloc(u->ops, sizeof(UndoOp) * new_cap);
+    if (o == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    u->ops = o;
+    u->opsCap = new_cap;
+  }
+}
+
+//record an op, typing and backspacing within one line extend the last op
+//instead of adding one, bytes are filled by the caller at the returned spot
+static char* undo_push(UndoLog *u, Uint8 kind, size_t line, size_t pos, size_t len) {
+  //anything undone is gone once a new edit comes in
+  u->nops = u->applied;
+  u->used = u->nops ? u->ops[u->nops - 1].at + u->ops[u->nops - 1].len : 0;
+  if (len + sizeof(UndoOp) > u->cap) {
+    //too big to keep, older ops would no longer line up with the text
+    u->nops = u->applied = u->used = 0;
+    return NULL;
+  }
+  undo_trim(u, len);
+  int recent = !u->sealed && u->now - u->lastTime < (Uint64)UNDO_MERGE_MS * 1000000;
+  u->lastTime = u->now;
+  u->sealed = 0;
+  undo_grow(u, len);
+  UndoOp *last = u->nops ? &u->ops[u->nops - 1] : NULL;
+  char *dst = NULL;
+  if (recent && last && last->kind == kind && last->line == line &&
+      !memchr(u->arena + last->at, '\n', last->len)) {
+    if (kind == UNDO_INSERT && last->pos + last->len == pos) {
+      dst = u->arena + u->used;
+    } else if (kind == UNDO_DELETE && pos == last->pos) {
+      //forward delete, bytes follow the ones already taken
+      dst = u->arena + u->used;
+    } else if (kind == UNDO_DELETE && pos + len == last->pos) {
+      //backspace, bytes go in front
+      memmove(u->arena + last->at + len, u->arena + last->at, last->len);
+      dst = u->arena + last->at;
+      last->pos = pos;
+    }
+  }
+  if (dst != NULL) {
+    last->len += len;
+  } else {
+    UndoOp *op = &u->ops[u->nops++];
+    op->kind = kind;
+    op->line = line;
+    op->pos = pos;
+    op->at = u->used;
+    op->len = len;
+    dst = u->arena + u->used;
+  }
+  u->used += len;
+  u->applied = u->nops;
+  return dst;
+}
+
+int buffer_edit_insert(Buffer *b, size_t line_index, size_t position, const char *s, size_t len) {
+  if (line_index >= b->nlines) return -1;
+  String *line = buffer_get_line(b, line_index);
+  if (position > line->length) return -1;
+  //cursor may sit after the line break, text still goes in front of it
+  if (position == line->length && position > 0 && line->data[position - 1] == '\n') {
+    position--;
+  }
+  //a newline is its own undo step, ops holding one are never extended
+  if (memchr(s, '\n', len)) undo_seal(&b->undo);
+  char *dst = undo_push(&b->undo, UNDO_INSERT, line_index, position, len);
+  if (dst) memcpy(dst, s, len);
+  b->modified = 1;
+  return buffer_insert_str(b, line_index, position, s, len);
+}
+
+int buffer_edit_delete(Buffer *b, size_t line_index, size_t position, size_t len) {
+  if (line_index >= b->nlines) return -1;
+  String *line = buffer_get_line(b, line_index);
+  if (position > line->length) return -1;
+  //recorded the way buffer_delete_range sees it
+  if (position == line->length && line_index + 1 < b->nlines) {
+    line_index++;
+    position = 0;
+  }
+  char *dst = undo_push(&b->undo, UNDO_DELETE, line_index, position, len);
+  if (dst) {
+    size_t got = buffer_copy_range(b, line_index, position, len, dst);
+    if (got < len) {
+      //range ran off the end, record only what is there
+      b->undo.ops[b->undo.nops - 1].len -= len - got;
+      b->undo.used -= len - got;
+      len = got;
+    }
+  }
+  b->modified = 1;
+  return buffer_delete_range(b, line_index, position, len);
+}
+
+//position right after s when it is inserted at (line, pos)
+static void text_end(size_t line, size_t pos, const char *s, size_t len, size_t *el, size_t *ep) {
+  const char *last = s + len;
+  while (last > s && last[-1] != '\n') last--;
+  if (last == s) {
+    *el = line;
+    *ep = pos + len;
+  } else {
+    *el = line + simd.count_newlines(s, len);
+    *ep = s + len - last;
+  }
+}
+
+int buffer_undo(Buffer *b, size_t *line_index, size_t *position) {
+  UndoLog *u = &b->undo;
+  if (u->applied == 0) return 0;
+  UndoOp *op = &u->ops[--u->applied];
+  const char *bytes = u->arena + op->at;
+  if (op->kind == UNDO_INSERT) {
+    buffer_delete_range(b, op->line, op->pos, op->len);
+    *line_index = op->line;
+    *position = op->pos;
+  } else {
+    buffer_insert_str(b, op->line, op->pos, bytes, op->len);
+    text_end(op->line, op->pos, bytes, op->len, line_index, position);
+  }
+  u->sealed = 1;
+  b->modified = 1;
+  return 1;
+}
+
+int buffer_redo(Buffer *b, size_t *line_index, size_t *position) {
+  UndoLog *u = &b->undo;
+  if (u->applied == u->nops) return 0;
+  UndoOp *op = &u->ops[u->applied++];
+  const char *bytes = u->arena + op->at;
+  if (op->kind == UNDO_INSERT) {
+    buffer_insert_str(b, op->line, op->pos, bytes, op->len);
+    text_end(op->line, op->pos, bytes, op->len, line_index, position);
+  } else {
+    buffer_delete_range(b, op->line, op->pos, op->len);
+    *line_index = op->line;
+    *position = op->pos;
+  }
+  u->sealed = 1;
+  b->modified = 1;
+  return 1;
+}
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//large file streaming
+static void stream_publish(StreamFile *s, Uint64 offset, Uint64 size, Uint32 nlines) {
+  SDL_LockMutex(s->lock);
+  if (s->nfound == s->foundCap) {
+    size_t new_cap = s->foundCap ? s->foundCap * 2 : 64;
+    StreamPage *f = realloc(s->found, sizeof(StreamPage) * new_cap);
+    if (f == NULL) {
+      SDL_UnlockMutex(s->lock);
+      return;
+    }
+    s->found = f;
+    s->foundCap = new_cap;
+  }
+  StreamPage *pg = &s->found[s->nfound++];
+  memset(pg, 0, sizeof(*pg));
+  pg->offset = offset;
+  pg->size = size;
+  pg->nlines = nlines;
+  SDL_BroadcastCondition(s->progress);
+  SDL_UnlockMutex(s->lock);
+}
+
+//background scan, counts lines chunk by chunk and cuts a page every
+//STREAM_PAGE_LINES lines, nothing of the file is kept
+static int stream_scan(void *data) {
+  StreamFile *s = data;
+  SDL_IOStream *io = SDL_IOFromFile(s->path, "rb");
+  char *chunk = malloc(STREAM_SCAN_CHUNK);
+  Uint64 pos = 0;
+  Uint64 pageStart = 0;
+  Uint32 pageLines = 0;
+  char lastByte = '\n';
+  size_t got;
+  while (io != NULL && chunk != NULL && !SDL_GetAtomicInt(&s->stop) &&
+         (got = SDL_ReadIO(io, chunk, STREAM_SCAN_CHUNK)) > 0) {
+    const char *p = chunk;
+    const char *end = chunk + got;
+    size_t cnt = simd.count_newlines(chunk, got);
+    while (pageLines + cnt >= STREAM_PAGE_LINES) {
+      Uint32 need = STREAM_PAGE_LINES - pageLines;
+      for (Uint32 k = 0; k < need; k++) {
+        p = simd.find_newline(p, end - p) + 1;
+      }
+      cnt -= need;
+      Uint64 pageEnd = pos + (p - chunk);
+      stream_publish(s, pageStart, pageEnd - pageStart, STREAM_PAGE_LINES);
+      pageStart = pageEnd;
+      pageLines = 0;
+    }
+    pageLines += cnt;
+    lastByte = chunk[got - 1];
+    pos += got;
+
+    SDL_LockMutex(s->lock);
+    s->foundChars += simd.count_utf8(chunk, got);
+    s->scanned = pos;
+    SDL_UnlockMutex(s->lock);
+    SDL_Event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = loadEventType;
+    SDL_PushEvent(&ev);
+  }
+  //tail page, a last line without newline counts as well
+  if (pos > pageStart) {
+    stream_publish(s, pageStart, pos - pageStart, pageLines + (lastByte != '\n'));
+  }
+  free(chunk);
+  if (io) SDL_CloseIO(io);
+  SDL_LockMutex(s->lock);
+  SDL_SetAtomicInt(&s->done, 1);
+  SDL_BroadcastCondition(s->progress);
+  SDL_UnlockMutex(s->lock);
+  SDL_Event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.type = loadEventType;
+  SDL_PushEvent(&ev);
+  return 0;
+}
+
+StreamFile* stream_open(const char *path, size_t budget, LinePool *pool) {
+  StreamFile *s = calloc(1, sizeof(StreamFile));
+  if (s == NULL) return NULL;
+  s->pool = pool;
+  s->path = malloc(strlen(path) + 1);
+  s->io = SDL_IOFromFile(path, "rb");
+  s->lock = SDL_CreateMutex();
+  s->progress = SDL_CreateCondition();
+  s->fd = -1;
+#ifdef SE_HAVE_MMAP
+  s->fd = open(path, O_RDONLY);
+  if (s->fd < 0) {
+    stream_close(s);
+    return NULL;
+  }
+#endif
+  if (s->path == NULL || s->io == NULL || s->lock == NULL || s->progress == NULL) {
+    stream_close(s);
+    return NULL;
+  }
+  strcpy(s->path, path);
+  s->fileSize = SDL_GetIOSize(s->io);
+  s->budget = budget;
+  s->scanner = SDL_CreateThread(stream_scan, "stream_scan", s);
+  if (s->scanner == NULL) {
+    stream_close(s);
+    return NULL;
+  }
+  return s;
+}
+
+//firstLine of every page, recomputed from the first page whose count changed
+static void stream_fix_prefix(StreamFile *s) {
+  for (size_t k = s->prefixFrom; k < s->npages; k++) {
+    s->pages[k].firstLine = k ? s->pages[k - 1].firstLine + s->pages[k - 1].nlines : 0;
+  }
+  s->prefixFrom = s->npages;
+}
+
+int stream_poll(Buffer *b) {
+  StreamFile *s = b->stream;
+  size_t added = 0;
+  SDL_LockMutex(s->lock);
+  if (s->nfound > 0 && s->npages + s->nfound > s->pageCap) {
+    size_t new_cap = s->pageCap ? s->pageCap : 64;
+    while (new_cap < s->npages + s->nfound) new_cap *= 2;
+    StreamPage *pg = realloc(s->pages, sizeof(StreamPage) * new_cap);
+    if (pg == NULL) {
+      SDL_UnlockMutex(s->lock);
+      return 0;
+    }
+    s->pages = pg;
+    s->pageCap = new_cap;
+  }
+  for (size_t k = 0; k < s->nfound; k++) {
+    s->pages[s->npages++] = s->found[k];
+    added += s->found[k].nlines;
+    b->totalBytes += s->found[k].size;
+  }
+  s->nfound = 0;
+  b->totalSizeChars += s->foundChars;
+  s->foundChars = 0;
+  SDL_UnlockMutex(s->lock);
+
+  b->nlines += added;
+  if (added > 0) buffer_damage(b, b->nlines - added, SIZE_MAX);
+  //an empty file still needs a line for the cursor
+  if (SDL_GetAtomicInt(&s->done) && b->nlines == 0) {
+    buffer_insert_line(b, 0, line_new(&b->pool));
+    added++;
+  }
+  return added > 0;
+}
+
+//page holding line index, skipping pages emptied by edits
+static size_t stream_find_page(StreamFile *s, size_t index) {
+  stream_fix_prefix(s);
+  size_t lo = 0;
+  size_t hi = s->npages;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (s->pages[mid].firstLine <= index) lo = mid;
+    else hi = mid;
+  }
+  while (lo + 1 < s->npages && index >= s->pages[lo].firstLine + s->pages[lo].nlines) lo++;
+  return lo;
+}
+
+static size_t stream_page_cost(const StreamPage *pg) {
+  return pg->size + (size_t)pg->cap * (sizeof(Line) + sizeof(Line*));
+}
+
+//read a clean page back from the file and index its lines
+static int stream_page_load(StreamFile *s, size_t k) {
+  StreamPage *pg = &s->pages[k];
+  if (pg->lines != NULL) return 0;
+  if (s->nresident == s->residentCap) {
+    size_t new_cap = s->residentCap ? s->residentCap * 2 : 16;
+    size_t *r = realloc(s->residentPages, sizeof(size_t) * new_cap);
+    if (r == NULL) return -1;
+    s->residentPages = r;
+    s->residentCap = new_cap;
+  }
+  pg->bytes = malloc(pg->size ? pg->size : 1);
+  pg->cap = pg->nlines ? pg->nlines : 1;
+  pg->lines = malloc(sizeof(Line*) * pg->cap);
+  if (pg->bytes == NULL || pg->lines == NULL) {
+    free(pg->bytes);
+    free(pg->lines);
+    pg->bytes = NULL;
+    pg->lines = NULL;
+    return -1;
+  }
+  size_t got = 0;
+  if (SDL_SeekIO(s->io, pg->offset, SDL_IO_SEEK_SET) >= 0) {
+    size_t r;
+    while (got < pg->size && (r = SDL_ReadIO(s->io, pg->bytes + got, pg->size - got)) > 0) got += r;
+  }
+  const char *p = pg->bytes;
+  const char *end = pg->bytes + got;
+  for (Uint32 i = 0; i < pg->nlines; i++) {
+    //a file changed on disk can come up short, pad with empty lines
+    const char *nl = p < end ? simd.find_newline(p, end - p) : NULL;
+    const char *e = nl ? nl + 1 : end;
+    Line *l = line_new_view(s->pool, p, e - p);
+    //the scan already counted these into the totals
+    l->bytes = e - p;
+    l->chars = simd.count_utf8(p, e - p);
+    pg->lines[i] = l;
+    p = e;
+  }
+  s->residentPages[s->nresident++] = k;
+  s->resident += stream_page_cost(pg);
+  return 0;
+}
+
+static void stream_page_unload(StreamFile *s, StreamPage *pg) {
+  s->resident -= stream_page_cost(pg);
+  for (Uint32 i = 0; i < pg->nlines; i++) line_free(s->pool, pg->lines[i]);
+  free(pg->lines);
+  free(pg->bytes);
+  pg->lines = NULL;
+  pg->bytes = NULL;
+  pg->cap = 0;
+}
+
+Line* stream_line(StreamFile *s, size_t index) {
+  if (s->npages == 0) return NULL;
+  size_t k = stream_find_page(s, index);
+  StreamPage *pg = &s->pages[k];
+  if (stream_page_load(s, k) != 0) return NULL;
+  size_t local = index - pg->firstLine;
+  if (local >= pg->nlines) return NULL;
+  pg->lastUse = ++s->useClock;
+  return pg->lines[local];
+}
+
+int stream_insert_line(StreamFile *s, size_t index, Line *l) {
+  if (s->npages == 0) {
+    //only an empty file gets here, give it an edited page
+    s->pages = calloc(1, sizeof(StreamPage));
+    if (s->pages == NULL) return -1;
+    s->npages = 1;
+    s->pageCap = 1;
+  }
+  //append to the page holding the line before, so end of page works too
+  size_t k = stream_find_page(s, index > 0 ? index - 1 : 0);
+  StreamPage *pg = &s->pages[k];
+  if (stream_page_load(s, k) != 0) return -1;
+  size_t local = index - pg->firstLine;
+  if (local > pg->nlines) return -1;
+  if (pg->nlines == pg->cap) {
+    Uint32 new_cap = pg->cap ? pg->cap * 2 : 4;
+    Line **lines = realloc(pg->lines, sizeof(Line*) * new_cap);
+    if (lines == NULL) return -1;
+    s->resident += (size_t)(new_cap - pg->cap) * (sizeof(Line) + sizeof(Line*));
+    pg->lines = lines;
+    pg->cap = new_cap;
+  }
+  memmove(pg->lines + local + 1, pg->lines + local, sizeof(Line*) * (pg->nlines - local));
+  pg->lines[local] = l;
+  pg->nlines++;
+  pg->dirty = 1;
+  if (s->prefixFrom > k + 1) s->prefixFrom = k + 1;
+  return 0;
+}
+
+Line* stream_remove_line(StreamFile *s, size_t index) {
+  size_t k = stream_find_page(s, index);
+  StreamPage *pg = &s->pages[k];
+  if (stream_page_load(s, k) != 0) return NULL;
+  size_t local = index - pg->firstLine;
+  if (local >= pg->nlines) return NULL;
+  Line *l = pg->lines[local];
+  memmove(pg->lines + local, pg->lines + local + 1, sizeof(Line*) * (pg->nlines - local - 1));
+  pg->nlines--;
+  pg->dirty = 1;
+  if (s->prefixFrom > k + 1) s->prefixFrom = k + 1;
+  return l;
+}
+
+void stream_mark_dirty(StreamFile *s, size_t index) {
+  if (s->npages == 0) return;
+  s->pages[stream_find_page(s, index)].dirty = 1;
+}
+
+void stream_trim(StreamFile *s) {
+  int trimmed = 0;
+  while (s->resident > s->budget) {
+    size_t victim = s->nresident;
+    for (size_t r = 0; r < s->nresident; r++) {
+      StreamPage *pg = &s->pages[s->residentPages[r]];
+      if (pg->dirty) continue;
+      if (victim == s->nresident || pg->lastUse < s->pages[s->residentPages[victim]].lastUse) {
+        victim = r;
+      }
+    }
+    if (victim == s->nresident) break; //only edited pages left
+    stream_page_unload(s, &s->pages[s->residentPages[victim]]);
+    s->residentPages[victim] = s->residentPages[--s->nresident];
+    trimmed = 1;
+  }
+  //headers and spans of dropped pages went back to the pool, hand whole
+  //blocks of them back too or the pool keeps its high water mark
+  if (trimmed) pool_reclaim(s->pool);
+}
+
+void stream_close(StreamFile *s) {
+  if (s == NULL) return;
+  if (s->scanner) {
+    SDL_SetAtomicInt(&s->stop, 1);
+    SDL_WaitThread(s->scanner, NULL);
+  }
+  //the lines themselves go with the buffer's pool
+  for (size_t k = 0; k < s->npages; k++) {
+    free(s->pages[k].lines);
+    free(s->pages[k].bytes);
+  }
+  free(s->pages);
+  free(s->found);
+  free(s->residentPages);
+  if (s->io) SDL_CloseIO(s->io);
+#ifdef SE_HAVE_MMAP
+  if (s->fd >= 0) close(s->fd);
+#endif
+  if (s->progress) SDL_DestroyCondition(s->progress);
+  if (s->lock) SDL_DestroyMutex(s->lock);
+  free(s->path);
+  free(s);
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//regex
+enum { RX_SET, RX_SPLIT, RX_JMP, RX_MATCH };
+#define RX_EOL 256 //zero width symbols fed around each line, so anchors are
+#define RX_BOL 257 //ordinary transitions, threads not taking them stay put
+#define RX_SYMBOLS 258
+#define RX_SET_WORDS ((RX_SYMBOLS + 31) / 32)
+
+typedef Uint32 RxSet[RX_SET_WORDS];
+
+typedef struct {
+  Uint8 op;
+  int x; //next node, or first branch of a split
+  int y; //second branch of a split
+  int set; //symbols consumed by RX_SET
+} RxInst;
+
+struct RegexProg {
+  RxInst *code;
+  int ncode;
+  RxSet *sets;
+  int nsets;
+  Uint8 classOf[RX_SYMBOLS]; //symbols no set tells apart share a class
+  int nclasses;
+};
+
+enum { RXA_EMPTY, RXA_SET, RXA_CAT, RXA_ALT, RXA_REPEAT };
+
+typedef struct {
+  Uint8 kind;
+  int a;
+  int b;
+  int min;
+  int max; //-1 unbounded
+  int set;
+} RxAst;
+
+typedef struct {
+  const char *p;
+  const char *end;
+  RxAst *ast;
+  int nast;
+  int astCap;
+  RxSet *sets;
+  int nsets;
+  int setCap;
+  RxInst *code;
+  int ncode;
+  int codeCap;
+  const char *err;
+  int depth;
+} RxParser;
+
+static int rx_has(const Uint32 *set, int sym) {
+  return (set[sym >> 5] >> (sym & 31)) & 1;
+}
+
+static void rx_add(Uint32 *set, int sym) {
+  set[sym >> 5] |= 1u << (sym & 31);
+}
+
+static int rx_node(RxParser *r, int kind, int a, int b) {
+  if (r->nast == r->astCap) {
+    r->astCap = r->astCap ? r->astCap * 2 : 64;
+    r->ast = realloc(r->ast, r->astCap * sizeof(RxAst));
+    if (!r->ast) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  RxAst *n = &r->ast[r->nast];
+  memset(n, 0, sizeof(*n));
+  n->kind = kind;
+  n->a = a;
+  n->b = b;
+  return r->nast++;
+}
+
+static int rx_new_set(RxParser *r) {
+  if (r->nsets == r->setCap) {
+    r->setCap = r->setCap ? r->setCap * 2 : 16;
+    r->sets = realloc(r->sets, r->setCap * sizeof(RxSet));
+    if (!r->sets) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  memset(r->sets[r->nsets], 0, sizeof(RxSet));
+  return r->nsets++;
+}
+
+static int rx_set_node(RxParser *r, int set) {
+  int n = rx_node(r, RXA_SET, -1, -1);
+  r->ast[n].set = set;
+  return n;
+}
+
+//\d \w \s and their negations, 0 for any other escape
+static int rx_class_escape(char c, Uint32 *set) {
+  RxSet t;
+  memset(t, 0, sizeof(t));
+  switch (c | 0x20) {
+    case 'd':
+      for (int i = '0'; i <= '9'; i++) rx_add(t, i);
+      break;
+    case 'w':
+      for (int i = 0; i < 256; i++) if (SDL_isalnum(i) || i == '_') rx_add(t, i);
+      break;
+    case 's':
+      for (const char *s = " \t\r\n\f\v"; *s; s++) rx_add(t, *s);
+      break;
+    default:
+      return 0;
+  }
+  int neg = c >= 'A' && c <= 'Z';
+  for (int i = 0; i < 256; i++) if (rx_has(t, i) != neg) rx_add(set, i);
+  return 1;
+}
+
+static int rx_escape_byte(char c) {
+  switch (c) {
+    case 't': return '\t';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 'f': return '\f';
+    case 'v': return '\v';
+    case '0': return 0;
+  }
+  return (Uint8)c;
+}
+
+//[...] after the opening bracket
+static int rx_parse_class(RxParser *r) {
+  int set = rx_new_set(r);
+  int neg = 0;
+  if (r->p < r->end && *r->p == '^') {
+    neg = 1;
+    r->p++;
+  }
+  int first = 1;
+  while (r->p < r->end && (*r->p != ']' || first)) {
+    first = 0;
+    int lo;
+    if (*r->p == '\\') {
+      if (++r->p == r->end) break;
+      if (rx_class_escape(*r->p, r->sets[set])) {
+        r->p++;
+        continue;
+      }
+      lo = rx_escape_byte(*r->p++);
+    }
+    else lo = (Uint8)*r->p++;
+    int hi = lo;
+    if (r->p + 1 < r->end && *r->p == '-' && r->p[1] != ']') {
+      r->p++;
+      if (*r->p == '\\') {
+        if (++r->p == r->end) break;
+        hi = rx_escape_byte(*r->p++);
+      }
+      else hi = (Uint8)*r->p++;
+      if (hi < lo) {
+        r->err = "bad class range";
+        return -1;
+      }
+    }
+    for (int i = lo; i <= hi; i++) rx_add(r->sets[set], i);
+  }
+  if (r->p == r->end) {
+    r->err = "missing ]";
+    return -1;
+  }
+  r->p++;
+  if (neg) for (int i = 0; i < 256; i++) r->sets[set][i >> 5] ^= 1u << (i & 31);
+  return rx_set_node(r, set);
+}
+
+static int rx_parse_alt(RxParser *r);
+
+static int rx_parse_atom(RxParser *r) {
+  char c = *r->p++;
+  int set;
+  switch (c) {
+    case '(':
+      if (++r->depth > 200) {
+        r->err = "nested too deep";
+        return -1;
+      }
+      int n = rx_parse_alt(r);
+      r->depth--;
+      if (n < 0) return -1;
+      if (r->p == r->end || *r->p != ')') {
+        r->err = "missing )";
+        return -1;
+      }
+      r->p++;
+      return n;
+    case '[':
+      return rx_parse_class(r);
+    case '.':
+      set = rx_new_set(r);
+      for (int i = 0; i < 256; i++) if (i != '\n') rx_add(r->sets[set], i);
+      return rx_set_node(r, set);
+    case '^':
+    case '$':
+      set = rx_new_set(r);
+      rx_add(r->sets[set], c == '^' ? RX_BOL : RX_EOL);
+      return rx_set_node(r, set);
+    case '*':
+    case '+':
+    case '?':
+      r->err = "nothing to repeat";
+      return -1;
+    case '\\':
+      if (r->p == r->end) {
+        r->err = "trailing \\";
+        return -1;
+      }
+      set = rx_new_set(r);
+      c = *r->p++;
+      if (!rx_class_escape(c, r->sets[set])) rx_add(r->sets[set], rx_escape_byte(c));
+      return rx_set_node(r, set);
+  }
+  //a { that rx_parse_repeat did not take as a count is literal
+  set = rx_new_set(r);
+  rx_add(r->sets[set], (Uint8)c);
+  return rx_set_node(r, set);
+}
+
+static int rx_parse_count(RxParser *r, int *v) {
+  if (r->p == r->end || !SDL_isdigit((Uint8)*r->p)) return 0;
+  *v = 0;
+  while (r->p < r->end && SDL_isdigit((Uint8)*r->p)) {
+    *v = *v * 10 + (*r->p++ - '0');
+    if (*v > 1000) {
+      r->err = "repeat count too large";
+      return -1;
+    }
+  }
+  return 1;
+}
+
+static int rx_parse_repeat(RxParser *r) {
+  int n = rx_parse_atom(r);
+  while (n >= 0 && r->p < r->end) {
+    int min, max;
+    char c = *r->p;
+    if (c == '*') { min = 0; max = -1; }
+    else if (c == '+') { min = 1; max = -1; }
+    else if (c == '?') { min = 0; max = 1; }
+    else if (c == '{') {
+      const char *save = r->p++;
+      int ok = rx_parse_count(r, &min);
+      if (ok < 0) return -1;
+      max = min;
+      if (ok && r->p < r->end && *r->p == ',') {
+        r->p++;
+        ok = rx_parse_count(r, &max);
+        if (ok < 0) return -1;
+        if (!ok) max = -1;
+        ok = 1;
+      }
+      if (!ok || r->p == r->end || *r->p != '}') {
+        //not a counted repeat, the brace is literal
+        r->p = save;
+        break;
+      }
+      if (max >= 0 && max < min) {
+        r->err = "bad repeat range";
+        return -1;
+      }
+    }
+    else break;
+    r->p++;
+    int rep = rx_node(r, RXA_REPEAT, n, -1);
+    r->ast[rep].min = min;
+    r->ast[rep].max = max;
+    n = rep;
+  }
+  return n;
+}
+
+static int rx_parse_cat(RxParser *r) {
+  int n = rx_node(r, RXA_EMPTY, -1, -1);
+  while (r->p < r->end && *r->p != '|' && *r->p != ')') {
+    int a = rx_parse_repeat(r);
+    if (a < 0) return -1;
+    n = r->ast[n].kind == RXA_EMPTY ? a : rx_node(r, RXA_CAT, n, a);
+  }
+  return n;
+}
+
+static int rx_parse_alt(RxParser *r) {
+  int n = rx_parse_cat(r);
+  while (n >= 0 && r->p < r->end && *r->p == '|') {
+    r->p++;
+    int b = rx_parse_cat(r);
+    if (b < 0) return -1;
+    n = rx_node(r, RXA_ALT, n, b);
+  }
+  return n;
+}
+
+static int rx_emit(RxParser *r, int op, int x, int y) {
+  if (r->ncode == REGEX_MAX_NODES) {
+    r->err = "pattern too large";
+    return -1;
+  }
+  if (r->ncode == r->codeCap) {
+    r->codeCap = r->codeCap ? r->codeCap * 2 : 64;
+    r->code = realloc(r->code, r->codeCap * sizeof(RxInst));
+    if (!r->code) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  RxInst *in = &r->code[r->ncode];
+  in->op = op;
+  in->x = x;
+  in->y = y;
+  in->set = -1;
+  return r->ncode++;
+}
+
+//emits n so that it continues at the node after it, 0 on success
+static int rx_gen(RxParser *r, int n) {
+  const RxAst a = r->ast[n];
+  int pc, split, jmp;
+  switch (a.kind) {
+    case RXA_EMPTY:
+      return 0;
+    case RXA_SET:
+      if ((pc = rx_emit(r, RX_SET, 0, -1)) < 0) return -1;
+      r->code[pc].x = pc + 1;
+      r->code[pc].set = a.set;
+      return 0;
+    case RXA_CAT:
+      return rx_gen(r, a.a) || rx_gen(r, a.b) ? -1 : 0;
+    case RXA_ALT:
+      if ((split = rx_emit(r, RX_SPLIT, 0, 0)) < 0) return -1;
+      r->code[split].x = split + 1;
+      if (rx_gen(r, a.a)) return -1;
+      if ((jmp = rx_emit(r, RX_JMP, 0, -1)) < 0) return -1;
+      r->code[split].y = r->ncode;
+      if (rx_gen(r, a.b)) return -1;
+      r->code[jmp].x = r->ncode;
+      return 0;
+    case RXA_REPEAT:
+      for (int i = 0; i < a.min; i++) if (rx_gen(r, a.a)) return -1;
+      if (a.max < 0) {
+        //greedy loop, the body is tried before leaving
+        if ((split = rx_emit(r, RX_SPLIT, 0, 0)) < 0) return -1;
+        r->code[split].x = split + 1;
+        if (rx_gen(r, a.a)) return -1;
+        if (rx_emit(r, RX_JMP, split, -1) < 0) return -1;
+        r->code[split].y = r->ncode;
+        return 0;
+      }
+      {
+        //optional copies all skip to the end
+        int first = r->ncode;
+        for (int i = a.min; i < a.max; i++) {
+          if ((split = rx_emit(r, RX_SPLIT, 0, -1)) < 0) return -1;
+          r->code[split].x = split + 1;
+          if (rx_gen(r, a.a)) return -1;
+        }
+        for (pc = first; pc < r->ncode; pc++) {
+          if (r->code[pc].op == RX_SPLIT && r->code[pc].y == -1) r->code[pc].y = r->ncode;
+        }
+      }
+      return 0;
+  }
+  return -1;
+}
+
+RegexProg* regex_compile(const char *pattern, size_t len, char *err, size_t errLen) {
+  RxParser r;
+  memset(&r, 0, sizeof(r));
+  r.p = pattern;
+  r.end = pattern + len;
+  int root = rx_parse_alt(&r);
+  if (root >= 0 && r.p != r.end) {
+    r.err = "unmatched )";
+    root = -1;
+  }
+  if (root >= 0 && (rx_gen(&r, root) || rx_emit(&r, RX_MATCH, -1, -1) < 0)) root = -1;
+  free(r.ast);
+  if (root < 0) {
+    if (err && errLen) snprintf(err, errLen, "%s", r.err ? r.err : "bad pattern");
+    free(r.sets);
+    free(r.code);
+    return NULL;
+  }
+  RegexProg *p = calloc(1, sizeof(RegexProg));
+  if (!p) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  p->code = r.code;
+  p->ncode = r.ncode;
+  p->sets = r.sets;
+  p->nsets = r.nsets;
+  //symbols in the same class are treated alike by every set, so the DFA
+  //keeps one transition per class instead of per byte
+  Uint8 seen[RX_SYMBOLS];
+  memset(seen, 0, sizeof(seen));
+  for (int i = 0; i < RX_SYMBOLS; i++) {
+    if (seen[i]) continue;
+    for (int j = i; j < RX_SYMBOLS; j++) {
+      if (seen[j]) continue;
+      int same = 1;
+      for (int k = 0; k < p->nsets && same; k++) same = rx_has(p->sets[k], i) == rx_has(p->sets[k], j);
+      if (same) {
+        seen[j] = 1;
+        p->classOf[j] = p->nclasses;
+      }
+    }
+    p->nclasses++;
+  }
+  return p;
+}
+
+void regex_free(RegexProg *p) {
+  if (!p) return;
+  free(p->code);
+  free(p->sets);
+  free(p);
+}
+
+void regex_matcher_init(RegexMatcher *m, const RegexProg *p) {
+  memset(m, 0, sizeof(*m));
+  m->prog = p;
+  m->start = -1;
+  size_t n = p->ncode;
+  m->clist = malloc(n * sizeof(int));
+  m->nlist = malloc(n * sizeof(int));
+  m->cstart = malloc(n * sizeof(size_t));
+  m->nstart = malloc(n * sizeof(size_t));
+  m->stack = malloc((n * 2 + 1) * sizeof(int));
+  m->scratch = malloc(n * sizeof(int));
+  m->marks = calloc(n, sizeof(Uint32));
+  if (!m->clist || !m->nlist || !m->cstart || !m->nstart || !m->stack || !m->scratch || !m->marks) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void rx_dfa_flush(RegexMatcher *m) {
+  m->poolLen = 0;
+  m->nstates = 0;
+  m->bytes = 0;
+  m->start = -1;
+  if (m->table) memset(m->table, 0, m->tableCap * sizeof(int));
+}
+
+void regex_matcher_free(RegexMatcher *m) {
+  free(m->pool);
+  free(m->states);
+  free(m->trans);
+  free(m->table);
+  free(m->clist);
+  free(m->nlist);
+  free(m->cstart);
+  free(m->nstart);
+  free(m->stack);
+  free(m->scratch);
+  free(m->marks);
+  memset(m, 0, sizeof(*m));
+}
+
+static Uint32 rx_next_gen(RegexMatcher *m) {
+  if (++m->gen == 0) {
+    memset(m->marks, 0, m->prog->ncode * sizeof(Uint32));
+    m->gen = 1;
+  }
+  return m->gen;
+}
+
+//follows splits and jumps from pc in priority order, appending the
+//consuming and matching nodes not yet marked with gen
+static void rx_closure(RegexMatcher *m, int pc, size_t start, int *list, size_t *starts, int *n, Uint32 gen) {
+  const RxInst *code = m->prog->code;
+  int sp = 0;
+  m->stack[sp++] = pc;
+  while (sp) {
+    pc = m->stack[--sp];
+    if (m->marks[pc] == gen) continue;
+    m->marks[pc] = gen;
+    switch (code[pc].op) {
+      case RX_JMP:
+        m->stack[sp++] = code[pc].x;
+        break;
+      case RX_SPLIT:
+        m->stack[sp++] = code[pc].y;
+        m->stack[sp++] = code[pc].x;
+        break;
+      default:
+        if (starts) starts[*n] = start;
+        list[(*n)++] = pc;
+    }
+  }
+}
+
+static int rx_cmp_int(const void *a, const void *b) {
+  int x = *(const int*)a, y = *(const int*)b;
+  return (x > y) - (x < y);
+}
+
+static Uint32 rx_hash(const int *set, int n) {
+  Uint32 h = 2166136261u;
+  for (int i = 0; i < n; i++) h = (h ^ (Uint32)set[i]) * 16777619u;
+  return h;
+}
+
+//state for the node list in m->scratch, -1 when it would overflow the budget
+static int rx_dfa_state(RegexMatcher *m, int n) {
+  const RegexProg *p = m->prog;
+  int *set = m->scratch;
+  qsort(set, n, sizeof(int), rx_cmp_int);
+  Uint32 h = rx_hash(set, n);
+  if (m->tableCap) {
+    for (int i = h & (m->tableCap - 1);; i = (i + 1) & (m->tableCap - 1)) {
+      int s = m->table[i] - 1;
+      if (s < 0) break;
+      if (m->states[s].nset == n && !memcmp(m->pool + m->states[s].set, set, n * sizeof(int))) return s;
+    }
+  }
+  size_t cost = sizeof(RxState) + (n + p->nclasses + 2) * sizeof(int);
+  if (m->bytes + cost > REGEX_DFA_BUDGET && m->nstates) return -1;
+  if (m->nstates == m->stateCap) {
+    m->stateCap = m->stateCap ? m->stateCap * 2 : 64;
+    m->states = realloc(m->states, m->stateCap * sizeof(RxState));
+    m->trans = realloc(m->trans, (size_t)m->stateCap * p->nclasses * sizeof(int));
+    if (!m->states || !m->trans) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (m->poolLen + n > m->poolCap) {
+    m->poolCap = (m->poolLen + n) * 2;
+    m->pool = realloc(m->pool, m->poolCap * sizeof(int));
+    if (!m->pool) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  int s = m->nstates++;
+  RxState *st = &m->states[s];
+  st->set = m->poolLen;
+  st->nset = n;
+  st->match = 0;
+  for (int i = 0; i < n; i++) if (p->code[set[i]].op == RX_MATCH) st->match = 1;
+  memcpy(m->pool + m->poolLen, set, n * sizeof(int));
+  m->poolLen += n;
+  for (int c = 0; c < p->nclasses; c++) m->trans[(size_t)s * p->nclasses + c] = -1;
+  m->bytes += cost;
+  if (m->nstates * 2 > m->tableCap) {
+    m->tableCap = m->tableCap ? m->tableCap * 2 : 256;
+    free(m->table);
+    m->table = calloc(m->tableCap, sizeof(int));
+    if (!m->table) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < m->nstates; i++) {
+      RxState *o = &m->states[i];
+      int k = rx_hash(m->pool + o->set, o->nset) & (m->tableCap - 1);
+      while (m->table[k]) k = (k + 1) & (m->tableCap - 1);
+      m->table[k] = i + 1;
+    }
+  }
+  else {
+    int k = h & (m->tableCap - 1);
+    while (m->table[k]) k = (k + 1) & (m->tableCap - 1);
+    m->table[k] = s + 1;
+  }
+  return s;
+}
+
+//interns m->scratch, flushing the whole cache when the budget is spent
+static int rx_dfa_intern(RegexMatcher *m, int n) {
+  int s = rx_dfa_state(m, n);
+  if (s < 0) {
+    rx_dfa_flush(m);
+    if (++m->flushes > REGEX_MAX_FLUSHES) m->nfaOnly = 1;
+    s = rx_dfa_state(m, n);
+  }
+  return s;
+}
+
+static int rx_dfa_start(RegexMatcher *m) {
+  if (m->start < 0) {
+    int n = 0;
+    rx_closure(m, 0, 0, m->scratch, NULL, &n, rx_next_gen(m));
+    m->start = rx_dfa_intern(m, n);
+  }
+  return m->start;
+}
+
+//slow path of a transition, the start closure is added back on every step
+//so the DFA looks for a match starting anywhere
+static int rx_dfa_step(RegexMatcher *m, int s, int sym) {
+  const RegexProg *p = m->prog;
+  Uint32 gen = rx_next_gen(m);
+  int n = 0;
+  const int *set = m->pool + m->states[s].set;
+  for (int i = 0; i < m->states[s].nset; i++) {
+    const RxInst *in = &p->code[set[i]];
+    if (in->op != RX_SET) continue;
+    if (rx_has(p->sets[in->set], sym)) rx_closure(m, in->x, 0, m->scratch, NULL, &n, gen);
+    else if (sym >= RX_EOL) rx_closure(m, set[i], 0, m->scratch, NULL, &n, gen);
+  }
+  rx_closure(m, 0, 0, m->scratch, NULL, &n, gen);
+  int flushes = m->flushes;
+  int t = rx_dfa_intern(m, n);
+  //a flush dropped s, the transition is only cached while s lives
+  if (flushes == m->flushes) m->trans[(size_t)s * p->nclasses + p->classOf[sym]] = t;
+  return t;
+}
+
+static int rx_dfa_match(RegexMatcher *m, const char *text, size_t n) {
+  const RegexProg *p = m->prog;
+  const int nc = p->nclasses;
+  int s = rx_dfa_start(m);
+  if (m->states[s].match) return 1;
+  int flushes = m->flushes;
+  s = rx_dfa_step(m, s, RX_BOL);
+  for (size_t i = 0; i < n; i++) {
+    if (m->states[s].match) return 1;
+    int t = m->trans[(size_t)s * nc + p->classOf[(Uint8)text[i]]];
+    s = t >= 0 ? t : rx_dfa_step(m, s, (Uint8)text[i]);
+    if (m->flushes != flushes) {
+      if (m->nfaOnly) return 1; //let the Pike VM decide
+      flushes = m->flushes;
+    }
+  }
+  if (m->states[s].match) return 1;
+  int t = m->trans[(size_t)s * nc + p->classOf[RX_EOL]];
+  s = t >= 0 ? t : rx_dfa_step(m, s, RX_EOL);
+  return m->states[s].match;
+}
+
+//leftmost first match, threads carry their start and lower priority
+//threads are cut once a higher one matches
+static int rx_pike(RegexMatcher *m, const char *text, size_t n, size_t from, size_t *start, size_t *end) {
+  const RegexProg *p = m->prog;
+  int cn = 0, nn = 0;
+  int matched = 0;
+  int bol = from == 0;
+  int eol = 0;
+  size_t pos = from;
+  Uint32 gen = rx_next_gen(m);
+  for (;;) {
+    int sym = -1, adv = 0;
+    if (bol) {
+      sym = RX_BOL;
+      bol = 0;
+    }
+    else if (pos < n) {
+      sym = (Uint8)text[pos];
+      adv = 1;
+    }
+    else if (!eol) {
+      sym = RX_EOL;
+      eol = 1;
+    }
+    if (!matched) rx_closure(m, 0, pos, m->clist, m->cstart, &cn, gen);
+    if (!cn) break;
+    gen = rx_next_gen(m);
+    nn = 0;
+    for (int i = 0; i < cn; i++) {
+      const RxInst *in = &p->code[m->clist[i]];
+      if (in->op == RX_MATCH) {
+        *start = m->cstart[i];
+        *end = pos;
+        matched = 1;
+        break;
+      }
+      if (sym < 0) continue;
+      if (rx_has(p->sets[in->set], sym)) rx_closure(m, in->x, m->cstart[i], m->nlist, m->nstart, &nn, gen);
+      else if (sym >= RX_EOL) rx_closure(m, m->clist[i], m->cstart[i], m->nlist, m->nstart, &nn, gen);
+    }
+    int *tl = m->clist;
+    m->clist = m->nlist;
+    m->nlist = tl;
+    size_t *ts = m->cstart;
+    m->cstart = m->nstart;
+    m->nstart = ts;
+    cn = nn;
+    pos += adv;
+    if (sym < 0) break;
+  }
+  return matched;
+}
+
+int regex_find(RegexMatcher *m, const char *text, size_t n, size_t from, size_t *start, size_t *end) {
+  //most lines do not match and the DFA rules them out without tracking
+  //where matches start
+  if (from == 0 && !m->nfaOnly && !rx_dfa_match(m, text, n)) return 0;
+  return rx_pike(m, text, n, from, start, end);
+}
+
+//plain recursive backtracker over the same program, only for the benchmark,
+//returns -1 when it ran out of steps
+static int rx_backtrack(const RegexProg *p, int pc, const char *text, size_t n, size_t i, long *steps, int depth) {
+  for (;;) {
+    if (--*steps < 0 || depth > 10000) return -1;
+    const RxInst *in = &p->code[pc];
+    switch (in->op) {
+      case RX_MATCH:
+        return 1;
+      case RX_JMP:
+        pc = in->x;
+        break;
+      case RX_SPLIT: {
+        int r = rx_backtrack(p, in->x, text, n, i, steps, depth + 1);
+        if (r) return r;
+        pc = in->y;
+        break;
+      }
+      default: {
+        const Uint32 *set = p->sets[in->set];
+        if (rx_has(set, RX_BOL) && i == 0) pc = in->x;
+        else if (rx_has(set, RX_EOL) && i == n) pc = in->x;
+        else if (i < n && rx_has(set, (Uint8)text[i])) {
+          i++;
+          pc = in->x;
+        }
+        else return 0;
+      }
+    }
+  }
+}
+
+void regex_bench(size_t megabytes) {
+  static const char *words[] = { "int", "char", "void", "return", "buffer", "line_count", "x", "42", "(", ")", ";", "=", "{", "}", "data_17", "compute" };
+  const size_t size = megabytes << 20;
+  char *text = malloc(size);
+  if (!text) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  Uint32 seed = 1;
+  size_t len = 0;
+  while (len < size) {
+    seed = seed * 1103515245u + 12345u;
+    const char *w = words[(seed >> 16) % SDL_arraysize(words)];
+    size_t wl = strlen(w);
+    if (len + wl + 1 >= size) break;
+    memcpy(text + len, w, wl);
+    len += wl;
+    text[len++] = (seed >> 8) % 9 == 0 ? '\n' : ' ';
+  }
+  size_t bodyLen = len;
+  //lines of a's where (a|aa)*c backtracks exponentially
+  char *evil = malloc(size);
+  if (!evil) {
+    fprintf(stderr, "Memory reallocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t evilLen = 0;
+  while (evilLen + 41 < size) {
+    memset(evil + evilLen, 'a', 40);
+    evilLen += 40;
+    evil[evilLen++] = '\n';
+  }
+  static const struct { const char *pattern; int evil; } cases[] = {
+    { "compute", 0 },
+    { "[a-z]+_[0-9]+", 0 },
+    { "(int|char|void) +[a-z]+ *=", 0 },
+    { "^return.*;$", 0 },
+    { "(a|aa)*c", 1 },
+    { "(a*)*b", 1 },
+  };
+  printf("%-28s %12s %12s %16s %8s\n", "pattern", "dfa MB/s", "pike MB/s", "backtrack MB/s", "lines");
+  for (size_t c = 0; c < SDL_arraysize(cases); c++) {
+    char err[64];
+    RegexProg *p = regex_compile(cases[c].pattern, strlen(cases[c].pattern), err, sizeof(err));
+    if (!p) {
+      printf("%-28s %s\n", cases[c].pattern, err);
+      continue;
+    }
+    const char *t = cases[c].evil ? evil : text;
+    size_t n = cases[c].evil ? evilLen : bodyLen;
+    double rate[3];
+    size_t lines[3];
+    int gaveUp = 0;
+    for (int mode = 0; mode < 3; mode++) {
+      RegexMatcher m;
+      regex_matcher_init(&m, p);
+      if (mode == 1) m.nfaOnly = 1;
+      lines[mode] = 0;
+      Uint64 t0 = SDL_GetPerformanceCounter();
+      size_t scanned = 0;
+      for (const char *l = t, *e = t + n; l < e;) {
+        const char *nl = memchr(l, '\n', e - l);
+        size_t ll = nl ? (size_t)(nl - l) : (size_t)(e - l);
+        size_t ms, me;
+        if (mode < 2) lines[mode] += regex_find(&m, l, ll, 0, &ms, &me);
+        else {
+          long steps = 1000000;
+          int r = 0;
+          for (size_t i = 0; i <= ll && !r; i++) r = rx_backtrack(p, 0, l, ll, i, &steps, 0);
+          if (r < 0) gaveUp++;
+          else lines[mode] += r;
+        }
+        scanned += ll + 1;
+        l += ll + 1;
+        //a backtracker on the bad inputs would run for hours, a slice says enough
+        if (mode == 2 && SDL_GetPerformanceCounter() - t0 > SDL_GetPerformanceFrequency()) break;
+      }
+      double sec = (double)(SDL_GetPerformanceCounter() - t0) / SDL_GetPerformanceFrequency();
+      rate[mode] = scanned / sec / (1 << 20);
+      regex_matcher_free(&m);
+    }
+    printf("%-28s %12.1f %12.1f %16.3f %8zu", cases[c].pattern, rate[0], rate[1], rate[2], lines[0]);
+    if (lines[0] != lines[1]) printf("  dfa/pike mismatch %zu", lines[1]);
+    if (gaveUp) printf("  backtracker gave up on %d lines", gaveUp);
+    printf("\n");
+    regex_free(p);
+  }
+  free(text);
+  free(evil);
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//search
+void search_init(Search *s) {
+  memset(s, 0, sizeof(*s));
+  string_init(&s->status);
+  s->lock = SDL_CreateMutex();
+  s->wake = SDL_CreateCondition();
+}
+
+static void search_push_event(void) {
+  SDL_Event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.type = loadEventType;
+  SDL_PushEvent(&ev);
+}
+
+static void search_add_hit(SearchChunk *c, size_t line, size_t pos, size_t len) {
+  if (c->nhits == c->hitCap) {
+    size_t new_cap = c->hitCap ? c->hitCap * 2 : 16;
+    SearchHit *h = realloc(c->hits, sizeof(SearchHit) * new_cap);
+    if (h == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    c->hits = h;
+    c->hitCap = new_cap;
+  }
+  c->hits[c->nhits].line = line;
+  c->hits[c->nhits].pos = pos;
+  c->hits[c->nhits].len = len;
+  c->nhits++;
+}
+
+//all matches of the query in lines [from, to), non overlapping
+static void search_scan_chunk(Search *s, SearchChunk *c) {
+  //the lazy DFA is per chunk, it warms up in a few lines and workers need
+  //no shared cache
+  RegexMatcher m;
+  if (s->prog) regex_matcher_init(&m, s->prog);
+  for (size_t j = c->from; j < c->to; j++) {
+    const String *line = buffer_get_line(s->buf, j);
+    if (line == NULL) break;
+    if (s->prog) {
+      size_t n = line->length;
+      if (n > 0 && line->data[n - 1] == '\n') n--;
+      if (n > 0 && line->data[n - 1] == '\r') n--;
+      size_t from = 0, start, end;
+      while (from <= n && regex_find(&m, line->data, n, from, &start, &end)) {
+        //empty matches have nothing to show or jump over
+        if (end > start) search_add_hit(c, j, start, end - start);
+        from = end > start ? end : end + 1;
+      }
+      continue;
+    }
+    const char *p = line->data;
+    const char *end = line->data + line->length;
+    const char *hit;
+    while ((size_t)(end - p) >= s->qlen && (hit = simd.find_substr(p, end - p, s->query, s->qlen)) != NULL) {
+      search_add_hit(c, j, hit - line->data, s->qlen);
+      p = hit + s->qlen;
+    }
+  }
+  if (s->prog) regex_matcher_free(&m);
+  SDL_SetAtomicInt(&c->done, 1);
+}
+
+static int search_has_query(const Search *s) {
+  return s->qlen > 0 && (!s->regex || s->prog);
+}
+
+//hand out the next chunk of a pooled or inline round, SIZE_MAX when the
+//round is used up or of the other kind
+static size_t search_take_chunk(Search *s, int pooled) {
+  size_t idx = (size_t)-1;
+  SDL_LockMutex(s->lock);
+  if (s->pooled == pooled && s->roundNext < s->roundLen) {
+    idx = s->roundFrom + (s->roundStart + s->roundNext++) % s->roundLen;
+  }
+  SDL_UnlockMutex(s->lock);
+  return idx;
+}
+
+static int search_worker(void *data) {
+  Search *s = data;
+  for (;;) {
+    SDL_LockMutex(s->lock);
+    while (!s->quit && (!s->pooled || s->roundNext >= s->roundLen)) SDL_WaitCondition(s->wake, s->lock);
+    int quit = s->quit;
+    SDL_UnlockMutex(s->lock);
+    if (quit) return 0;
+    //the round may have been cancelled in between, take the chunk under the read lock
+    SDL_LockRWLockForReading(s->buf->linesLock);
+    size_t idx = search_take_chunk(s, 1);
+    if (idx != (size_t)-1) search_scan_chunk(s, &s->chunks[idx]);
+    SDL_UnlockRWLock(s->buf->linesLock);
+    if (idx != (size_t)-1) search_push_event();
+  }
+}
+
+//stop handing out chunks and wait for the ones being scanned
+static void search_cancel(Search *s) {
+  if (s->buf && s->buf->linesLock) SDL_LockRWLockForWriting(s->buf->linesLock);
+  SDL_LockMutex(s->lock);
+  s->roundLen = 0;
+  s->roundNext = 0;
+  SDL_UnlockMutex(s->lock);
+  if (s->buf && s->buf->linesLock) SDL_UnlockRWLock(s->buf->linesLock);
+}
+
+static void search_status(Search *s) {
+  char tail[64];
+  snprintf(tail, sizeof(tail), "  %zu match%s%s", s->nhits, s->nhits == 1 ? "" : "es",
+           s->ndone < s->nchunks ? "..." : "");
+  if (s->regex && !s->prog && s->qlen > 0) snprintf(tail, sizeof(tail), "  %s", s->error);
+  s->status.length = 0;
+  string_append_str(&s->status, s->regex ? "Regex: " : "Find: ");
+  string_append_len(&s->status, s->query, s->qlen);
+  string_append_str(&s->status, tail);
+}
+
+//chunks for lines [from, b->nlines) and a round over them starting near
+//the origin, only called with no round running
+static void search_add_round(Search *s, size_t from) {
+  Buffer *b = s->buf;
+  size_t first = s->nchunks;
+  size_t need = s->nchunks + (b->nlines - from + SEARCH_CHUNK_LINES - 1) / SEARCH_CHUNK_LINES;
+  //the line array is only read from other threads in the big case
+  int pooled = !b->stream && b->nlines - from >= SEARCH_POOL_MIN;
+  if (pooled && b->linesLock == NULL) b->linesLock = SDL_CreateRWLock();
+  if (b->linesLock) SDL_LockRWLockForWriting(b->linesLock);
+  if (need > s->chunkCap) {
+    size_t new_cap = s->chunkCap ? s->chunkCap : 64;
+    while (new_cap < need) new_cap *= 2;
+    SearchChunk *c = realloc(s->chunks, sizeof(SearchChunk) * new_cap);
+    if (c == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    s->chunks = c;
+    s->chunkCap = new_cap;
+  }
+  for (size_t j = from; j < b->nlines; j += SEARCH_CHUNK_LINES) {
+    SearchChunk *c = &s->chunks[s->nchunks++];
+    memset(c, 0, sizeof(*c));
+    c->from = j;
+    c->to = j + SEARCH_CHUNK_LINES < b->nlines ? j + SEARCH_CHUNK_LINES : b->nlines;
+  }
+  size_t start = 0;
+  if (s->originLine >= from) {
+    start = (s->originLine - from) / SEARCH_CHUNK_LINES;
+    if (start >= s->nchunks - first) start = 0;
+  }
+  if (pooled && s->workers == NULL) {
+    int n = SDL_GetNumLogicalCPUCores() - 1;
+    n = n < 1 ? 1 : n > 8 ? 8 : n;
+    s->workers = malloc(sizeof(SDL_Thread*) * n);
+    for (int k = 0; s->workers && k < n; k++) {
+      s->workers[k] = SDL_CreateThread(search_worker, "search", s);
+      if (s->workers[k] == NULL) break;
+      s->nworkers++;
+    }
+  }
+  if (s->nworkers == 0) pooled = 0;
+  SDL_LockMutex(s->lock);
+  s->roundFrom = first;
+  s->roundLen = s->nchunks - first;
+  s->roundStart = start;
+  s->roundNext = 0;
+  s->pooled = pooled;
+  SDL_UnlockMutex(s->lock);
+  if (b->linesLock) SDL_UnlockRWLock(b->linesLock);
+  if (pooled) SDL_BroadcastCondition(s->wake);
+}
+
+static void search_drop_chunks(Search *s) {
+  for (size_t k = 0; k < s->nchunks; k++) free(s->chunks[k].hits);
+  s->nchunks = 0;
+  s->ndone = 0;
+  s->nhits = 0;
+}
+
+void search_clear(Search *s) {
+  search_cancel(s);
+  search_drop_chunks(s);
+  s->pendingJump = 0;
+}
+
+void search_set_query(Search *s, Buffer *b, const char *q, size_t len) {
+  search_clear(s);
+  s->buf = b;
+  if (len > SEARCH_MAX_QUERY) len = SEARCH_MAX_QUERY;
+  memmove(s->query, q, len);
+  s->qlen = len;
+  regex_free(s->prog);
+  s->prog = NULL;
+  if (s->regex && len > 0) s->prog = regex_compile(s->query, len, s->error, sizeof(s->error));
+  if (search_has_query(s) && b->nlines > 0) {
+    s->pendingJump = 1;
+    s->pendingStrict = 0;
+    search_add_round(s, 0);
+  }
+  search_status(s);
+}
+
+//first hit after (dir 1) or before (dir -1) the origin inside chunk c
+static const SearchHit* search_hit_in(const Search *s, const SearchChunk *c, int dir) {
+  if (dir > 0) {
+    for (size_t k = 0; k < c->nhits; k++) {
+      const SearchHit *h = &c->hits[k];
+      if (h->line > s->originLine ||
+          (h->line == s->originLine && (h->pos > s->originPos || (!s->pendingStrict && h->pos == s->originPos)))) {
+        return h;
+      }
+    }
+  } else {
+    for (size_t k = c->nhits; k-- > 0; ) {
+      const SearchHit *h = &c->hits[k];
+      if (h->line < s->originLine || (h->line == s->originLine && h->pos < s->originPos)) return h;
+    }
+  }
+  return NULL;
+}
+
+static size_t search_chunk_of(const Search *s, size_t index) {
+  //chunks are in line order, rounds only ever append
+  size_t lo = 0;
+  size_t hi = s->nchunks;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (s->chunks[mid].from <= index) lo = mid;
+    else hi = mid;
+  }
+  return lo;
+}
+
+//walk chunks from the origin in the jump direction, wrapping around once,
+//a chunk still being scanned keeps the jump pending
+static int search_try_jump(Search *s, size_t *line, size_t *pos) {
+  if (s->pendingJump == 0 || s->nchunks == 0) return 0;
+  int dir = s->pendingJump;
+  size_t start = search_chunk_of(s, s->originLine);
+  for (size_t k = 0; k <= s->nchunks; k++) {
+    size_t idx = dir > 0 ? (start + k) % s->nchunks : (start + s->nchunks - k % s->nchunks) % s->nchunks;
+    SearchChunk *c = &s->chunks[idx];
+    if (!SDL_GetAtomicInt(&c->done)) return 0;
+    const SearchHit *h = NULL;
+    if (k == 0) h = search_hit_in(s, c, dir);
+    else if (c->nhits > 0) h = dir > 0 ? &c->hits[0] : &c->hits[c->nhits - 1];
+    //back at the start chunk, hits on the other side of the origin count now
+    if (k == s->nchunks && c->nhits > 0) h = dir > 0 ? &c->hits[0] : &c->hits[c->nhits - 1];
+    if (h != NULL) {
+      *line = h->line;
+      *pos = h->pos;
+      s->pendingJump = 0;
+      return 1;
+    }
+  }
+  s->pendingJump = 0; //no hits anywhere
+  return 0;
+}
+
+int search_jump(Search *s, int dir, size_t *line, size_t *pos) {
+  if (!search_has_query(s)) return 0;
+  if (s->nchunks == 0 && s->buf != NULL) {
+    //hits were dropped by an edit, scan again
+    search_add_round(s, 0);
+  }
+  s->originLine = *line;
+  s->originPos = *pos;
+  s->pendingJump = dir;
+  s->pendingStrict = 1;
+  return search_try_jump(s, line, pos);
+}
+
+int search_poll(Search *s, size_t *line, size_t *pos) {
+  if (s->buf == NULL || !search_has_query(s)) return 0;
+  if (!s->pooled) {
+    //inline round, a slice per call so streaming files keep the loop alive
+    Uint64 until = SDL_GetTicks() + SEARCH_SLICE_MS;
+    size_t idx;
+    while ((idx = search_take_chunk(s, 0)) != (size_t)-1) {
+      search_scan_chunk(s, &s->chunks[idx]);
+      if (SDL_GetTicks() >= until) break;
+    }
+    if (s->roundNext < s->roundLen) search_push_event();
+  }
+  s->ndone = 0;
+  s->nhits = 0;
+  for (size_t k = 0; k < s->nchunks; k++) {
+    if (SDL_GetAtomicInt(&s->chunks[k].done)) {
+      s->ndone++;
+      s->nhits += s->chunks[k].nhits;
+    }
+  }
+  //lines that arrived after the round started get their own round
+  size_t covered = s->nchunks ? s->chunks[s->nchunks - 1].to : 0;
+  if (s->ndone == s->nchunks && covered < s->buf->nlines) {
+    search_add_round(s, covered);
+    if (!s->pooled) search_push_event();
+  }
+  search_status(s);
+  return search_try_jump(s, line, pos);
+}
+
+int search_finish(Search *s, size_t *line, size_t *pos) {
+  int landed = 0;
+  for (;;) {
+    size_t l, p;
+    if (search_poll(s, &l, &p)) {
+      *line = l;
+      *pos = p;
+      landed = 1;
+    }
+    if (s->buf == NULL || !search_has_query(s) || s->ndone == s->nchunks) return landed;
+    if (s->pooled) SDL_Delay(1);
+  }
+}
+
+const SearchHit* search_line_hits(const Search *s, size_t index, size_t *n) {
+  *n = 0;
+  if (s->nchunks == 0 || !search_has_query(s)) return NULL;
+  SearchChunk *c = &s->chunks[search_chunk_of(s, index)];
+  if (index < c->from || index >= c->to || !SDL_GetAtomicInt(&c->done)) return NULL;
+  size_t lo = 0;
+  size_t hi = c->nhits;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (c->hits[mid].line < index) lo = mid + 1;
+    else hi = mid;
+  }
+  while (lo + *n < c->nhits && c->hits[lo + *n].line == index) (*n)++;
+  return c->hits + lo;
+}
+
+void search_free(Search *s) {
+  search_cancel(s);
+  SDL_LockMutex(s->lock);
+  s->quit = 1;
+  SDL_UnlockMutex(s->lock);
+  SDL_BroadcastCondition(s->wake);
+  for (int k = 0; k < s->nworkers; k++) SDL_WaitThread(s->workers[k], NULL);
+  free(s->workers);
+  search_drop_chunks(s);
+  free(s->chunks);
+  regex_free(s->prog);
+  string_free(&s->status);
+  SDL_DestroyCondition(s->wake);
+  SDL_DestroyMutex(s->lock);
+  memset(s, 0, sizeof(*s));
+}
+///////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+//syntax
+const Uint8 synColors[SYN_COUNT][3] = {
+  {255, 255, 255}, //text
+  {0, 200, 0}, //comment
+  {0, 20, 200}, //preprocessor
+  {0, 200, 200}, //types
+  {200, 130, 0}, //keywords
+  {200, 100, 100}, //strings and chars
+  {180, 140, 255}, //numbers
+};
+
+typedef struct {
+  const char *word;
+  Uint8 len;
+  Uint8 kind;
+} SynWord;
+
+static const SynWord synWords[] = {
+  {"void", 4, SYN_TYPE}, {"char", 4, SYN_TYPE}, {"float", 5, SYN_TYPE},
+  {"int", 3, SYN_TYPE}, {"double", 6, SYN_TYPE}, {"long", 4, SYN_TYPE},
+  {"short", 5, SYN_TYPE}, {"unsigned", 8, SYN_TYPE}, {"signed", 6, SYN_TYPE},
+  {"size_t", 6, SYN_TYPE}, {"struct", 6, SYN_TYPE}, {"union", 5, SYN_TYPE},
+  {"enum", 4, SYN_TYPE}, {"typedef", 7, SYN_TYPE}, {"const", 5, SYN_TYPE},
+  {"static", 6, SYN_TYPE}, {"extern", 6, SYN_TYPE}, {"inline", 6, SYN_TYPE},
+  {"volatile", 8, SYN_TYPE}, {"bool", 4, SYN_TYPE},
+  {"if", 2, SYN_KEYWORD}, {"else", 4, SYN_KEYWORD}, {"for", 3, SYN_KEYWORD},
+  {"while", 5, SYN_KEYWORD}, {"do", 2, SYN_KEYWORD}, {"switch", 6, SYN_KEYWORD},
+  {"case", 4, SYN_KEYWORD}, {"default", 7, SYN_KEYWORD}, {"break", 5, SYN_KEYWORD},
+  {"continue", 8, SYN_KEYWORD}, {"return", 6, SYN_KEYWORD}, {"goto", 4, SYN_KEYWORD},
+  {"sizeof", 6, SYN_KEYWORD}, {"NULL", 4, SYN_KEYWORD},
+};
+
+static int syn_ident_start(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static int syn_ident(char c) {
+  return syn_ident_start(c) || (c >= '0' && c <= '9');
+}
+
+static Uint8 syntax_word(const char *w, size_t len) {
+  for (size_t k = 0; k < sizeof(synWords) / sizeof(synWords[0]); k++) {
+    if (synWords[k].len == len && synWords[k].word[0] == w[0] &&
+        memcmp(synWords[k].word, w, len) == 0) {
+      return synWords[k].kind;
+    }
+  }
+  return SYN_TEXT;
+}
+
+static void syntax_push(LinePool *pool, Line *l, size_t start, size_t len, Uint8 kind) {
+  if (len == 0) return;
+  if (l->nspans > 0) {
+    SynSpan *p = &l->spans[l->nspans - 1];
+    if (p->kind == kind && p->start + p->len == start) {
+      p->len += len;
+      return;
+    }
+  }
+  if (l->nspans == l->spanCap) {
+    int new_cap = l->spanCap ? l->spanCap * 2 : 4;
+    SynSpan *sp = pool_grow(pool, l->spans, sizeof(SynSpan) * l->spanCap, sizeof(SynSpan) * new_cap,
+                            sizeof(SynSpan) * l->nspans);
+    if (sp == NULL) return; //line just shows less colour
+    l->spans = sp;
+    l->spanCap = new_cap;
+  }
+  l->spans[l->nspans].start = start;
+  l->spans[l->nspans].len = len;
+  l->spans[l->nspans].kind = kind;
+  l->nspans++;
+}
+
+//scan a quoted literal from i (after the quote), returns the index after
+//the closing quote, *open is set when a backslash continues it on the next line
+static size_t syntax_quoted(const char *d, size_t n, size_t i, char q, int *open) {
+  *open = 0;
+  while (i < n) {
+    if (d[i] == '\\') {
+      if (i + 1 >= n) {
+        *open = 1;
+        return n;
+      }
+      i += 2;
+      continue;
+    }
+    if (d[i] == q) return i + 1;
+    i++;
+  }
+  return n;
+}
+
+//find */ from i, returns index after it or n when the comment goes on
+static size_t syntax_block_end(const char *d, size_t n, size_t i, int *open) {
+  for (; i + 1 < n; i++) {
+    if (d[i] == '*' && d[i + 1] == '/') {
+      *open = 0;
+      return i + 2;
+    }
+  }
+  *open = 1;
+  return n;
+}
+
+void syntax_lex_line(LinePool *pool, Line *l, Uint8 state) {
+  const char *d = l->text.data;
+  size_t n = l->text.length;
+  size_t i = 0;
+  int open;
+  int atLineStart = 1;
+  while (n > 0 && (d[n - 1] == '\n' || d[n - 1] == '\r')) n--;
+  l->nspans = 0;
+  l->lexIn = state;
+
+  //finish what the previous line left open
+  if (state == LEX_BLOCK_COMMENT) {
+    i = syntax_block_end(d, n, 0, &open);
+    syntax_push(pool, l, 0, i, SYN_COMMENT);
+    if (!open) state = LEX_NORMAL;
+  } else if (state == LEX_STRING) {
+    i = syntax_quoted(d, n, 0, '"', &open);
+    syntax_push(pool, l, 0, i, SYN_STRING);
+    if (!open) state = LEX_NORMAL;
+  }
+
+  while (i < n) {
+    char c = d[i];
+    int first = atLineStart;
+    if (c != ' ' && c != '\t') atLineStart = 0;
+
+    if (c == '/' && i + 1 < n && d[i + 1] == '/') {
+      syntax_push(pool, l, i, n - i, SYN_COMMENT);
+      i = n;
+    } else if (c == '/' && i + 1 < n && d[i + 1] == '*') {
+      size_t j = syntax_block_end(d, n, i + 2, &open);
+      syntax_push(pool, l, i, j - i, SYN_COMMENT);
+      if (open) state = LEX_BLOCK_COMMENT;
+      i = j;
+    } else if (c == '"' || c == '\'') {
+      size_t j = syntax_quoted(d, n, i + 1, c, &open);
+      syntax_push(pool, l, i, j - i, SYN_STRING);
+      if (open && c == '"') state = LEX_STRING;
+      i = j;
+    } else if (c == '#' && first) {
+      size_t j = i + 1;
+      while (j < n && (d[j] == ' ' || d[j] == '\t')) j++;
+      while (j < n && syn_ident(d[j])) j++;
+      syntax_push(pool, l, i, j - i, SYN_PREPROC);
+      //<header> of an include reads like a string
+      while (j < n && (d[j] == ' ' || d[j] == '\t')) j++;
+      if (j < n && d[j] == '<') {
+        size_t k = j + 1;
+        while (k < n && d[k] != '>') k++;
+        if (k < n) k++;
+        syntax_push(pool, l, j, k - j, SYN_STRING);
+      }
+      i = j;
+    } else if ((c >= '0' && c <= '9') || (c == '.' && i + 1 < n && d[i + 1] >= '0' && d[i + 1] <= '9')) {
+      size_t j = i + 1;
+      while (j < n && (syn_ident(d[j]) || d[j] == '.' ||
+                       ((d[j] == '+' || d[j] == '-') &&
+                        (d[j - 1] == 'e' || d[j - 1] == 'E' || d[j - 1] == 'p' || d[j - 1] == 'P')))) {
+        j++;
+      }
+      syntax_push(pool, l, i, j - i, SYN_NUMBER);
+      i = j;
+    } else if (syn_ident_start(c)) {
+      size_t j = i + 1;
+      while (j < n && syn_ident(d[j])) j++;
+      Uint8 kind = syntax_word(d + i, j - i);
+      if (kind != SYN_TEXT) syntax_push(pool, l, i, j - i, kind);
+      i = j;
+    } else {
+      i++;
+    }
+  }
+  l->lexOut = state;
+  l->lexDirty = 0;
+}
+
+void syntax_update(Buffer *b, size_t upto) {
+  if (b->nlines == 0 || b->lexFrom >= b->nlines) return;
+  if (upto >= b->nlines) upto = b->nlines - 1;
+  size_t i = b->lexFrom;
+  Uint8 state = i == 0 ? LEX_NORMAL : buffer_get_line_info(b, i - 1)->lexOut;
+  while (i < b->nlines) {
+    Line *l = buffer_get_line_info(b, i);
+    if ((i > b->lexTo || b->lexFrom > b->lexTo) && !l->lexDirty && l->lexIn == state) {
+      //cached lines from here on were lexed with the same start state
+      i = b->nlines;
+      break;
+    }
+    if (i > upto) break;
+    syntax_lex_line(&b->pool, l, state);
+    buffer_damage(b, i, i); //colors may differ
+    state = l->lexOut;
+    i++;
+  }
+  b->lexFrom = i;
+  if (i >= b->nlines) b->lexTo = 0;
+}
+
+void syntax_update_view(Buffer *b, size_t first, size_t last) {
+  if (b->stream == NULL) {
+    syntax_update(b, last);
+    return;
+  }
+  Uint8 state = LEX_NORMAL;
+  for (size_t i = first; i <= last && i < b->nlines; i++) {
+    Line *l = buffer_get_line_info(b, i);
+    if (i == first && !l->lexDirty) state = l->lexIn;
+    if (l->lexDirty || l->lexIn != state) {
+      syntax_lex_line(&b->pool, l, state);
+      buffer_damage(b, i, i);
+    }
+    state = l->lexOut;
+  }
+}
+//////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//glyph batch
+static void batch_grow(GlyphBatch *b, int quads) {
+  SDL_Vertex *v = realloc(b->vertices, sizeof(SDL_Vertex) * 4 * quads);
+  int *idx = realloc(b->indices, sizeof(int) * 6 * quads);
+  if (v == NULL || idx == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  //two triangles per quad, never change so fill once
+  for (int q = b->capacity; q < quads; q++) {
+    idx[q * 6 + 0] = q * 4 + 0;
+    idx[q * 6 + 1] = q * 4 + 1;
+    idx[q * 6 + 2] = q * 4 + 2;
+    idx[q * 6 + 3] = q * 4 + 2;
+    idx[q * 6 + 4] = q * 4 + 3;
+    idx[q * 6 + 5] = q * 4 + 0;
+  }
+  b->vertices = v;
+  b->indices = idx;
+  b->capacity = quads;
+}
+
+void batch_init(GlyphBatch *b, SDL_Texture *texture, int quads) {
+  b->vertices = NULL;
+  b->indices = NULL;
+  b->nquads = 0;
+  b->capacity = 0;
+  b->texture = texture;
+  b->texW = 1;
+  b->texH = 1;
+  if (texture) SDL_GetTextureSize(texture, &b->texW, &b->texH);
+  batch_grow(b, quads);
+}
+
+void batch_glyph(GlyphBatch *b, const CharInfo *chInfo, float x, float y, Uint8 r, Uint8 g, Uint8 bl) {
+  if (b->nquads == b->capacity) {
+    batch_grow(b, b->capacity * 2);
+  }
+  SDL_FColor color = {r / 255.0f, g / 255.0f, bl / 255.0f, 1.0f};
+  float w = chInfo->srcRect.w;
+  float h = chInfo->srcRect.h;
+  float u0 = chInfo->srcRect.x / b->texW;
+  float v0 = chInfo->srcRect.y / b->texH;
+  float u1 = (chInfo->srcRect.x + w) / b->texW;
+  float v1 = (chInfo->srcRect.y + h) / b->texH;
+  SDL_Vertex *v = b->vertices + b->nquads * 4;
+  v[0] = (SDL_Vertex){{x, y}, color, {u0, v0}};
+  v[1] = (SDL_Vertex){{x + w, y}, color, {u1, v0}};
+  v[2] = (SDL_Vertex){{x + w, y + h}, color, {u1, v1}};
+  v[3] = (SDL_Vertex){{x, y + h}, color, {u0, v1}};
+  b->nquads++;
+  frameGlyphs++;
+}
+
+void batch_flush(GlyphBatch *b) {
+  if (b->nquads == 0) return;
+  SDL_RenderGeometry(renderer, b->texture, b->vertices, b->nquads * 4, b->indices, b->nquads * 6);
+  frameDrawCalls++;
+  b->nquads = 0;
+}
+
+void batch_free(GlyphBatch *b) {
+  free(b->vertices);
+  free(b->indices);
+  b->vertices = NULL;
+  b->indices = NULL;
+  b->nquads = 0;
+  b->capacity = 0;
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//glyph cache
+void glyph_cache_init(GlyphCache *g) {
+  memset(g, 0, sizeof(*g));
+}
+
+static CachedGlyph* glyph_slot(GlyphCache *g, Uint32 cp) {
+  size_t mask = g->tableCap - 1;
+  size_t i = (cp * 2654435761u) & mask;
+  while (g->table[i].cp != 0 && g->table[i].cp != cp) i = (i + 1) & mask;
+  return &g->table[i];
+}
+
+static void glyph_table_grow(GlyphCache *g) {
+  CachedGlyph *old = g->table;
+  size_t oldCap = g->tableCap;
+  g->tableCap = oldCap ? oldCap * 2 : 256;
+  g->table = calloc(g->tableCap, sizeof(CachedGlyph));
+  if (g->table == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t k = 0; k < oldCap; k++) {
+    if (old[k].cp != 0) *glyph_slot(g, old[k].cp) = old[k];
+  }
+  free(old);
+}
+
+//empty page k for reuse, its pending quads are drawn first since they
+//point at the old pixels
+static void glyph_page_evict(GlyphCache *g, int k) {
+  GlyphPage *pg = &g->pages[k];
+  batch_flush(&pg->batch);
+  pg->nshelves = 0;
+  pg->top = 0;
+  //rehash the survivors, open addressing has no cheap delete
+  CachedGlyph *old = g->table;
+  size_t oldCap = g->tableCap;
+  g->table = calloc(oldCap, sizeof(CachedGlyph));
+  if (g->table == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  g->count = 0;
+  for (size_t i = 0; i < oldCap; i++) {
+    if (old[i].cp != 0 && old[i].info.page != k + 1) {
+      *glyph_slot(g, old[i].cp) = old[i];
+      g->count++;
+    }
+  }
+  free(old);
+  g->evictions++;
+}
+
+//first shelf with room, else a new shelf under the last one
+static int glyph_page_pack(GlyphPage *pg, int w, int h, int *x, int *y) {
+  w += GLYPH_PAD;
+  h += GLYPH_PAD;
+  for (int k = 0; k < pg->nshelves; k++) {
+    GlyphShelf *sh = &pg->shelves[k];
+    if (h <= sh->h && sh->x + w <= GLYPH_PAGE_SIZE) {
+      *x = sh->x;
+      *y = sh->y;
+      sh->x += w;
+      return 1;
+    }
+  }
+  if (pg->top + h > GLYPH_PAGE_SIZE || w > GLYPH_PAGE_SIZE) return 0;
+  if (pg->nshelves == pg->shelfCap) {
+    int new_cap = pg->shelfCap ? pg->shelfCap * 2 : 16;
+    GlyphShelf *sh = realloc(pg->shelves, sizeof(GlyphShelf) * new_cap);
+    if (sh == NULL) return 0;
+    pg->shelves = sh;
+    pg->shelfCap = new_cap;
+  }
+  GlyphShelf *sh = &pg->shelves[pg->nshelves++];
+  sh->y = pg->top;
+  sh->h = h;
+  sh->x = w;
+  pg->top += h;
+  *x = 0;
+  *y = sh->y;
+  return 1;
+}
+
+static int glyph_page_new(GlyphCache *g) {
+  GlyphPage *pg = &g->pages[g->npages];
+  memset(pg, 0, sizeof(*pg));
+  pg->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                  GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE);
+  if (pg->texture == NULL) return -1;
+  SDL_SetTextureBlendMode(pg->texture, SDL_BLENDMODE_BLEND);
+  //transparent start, padding around glyphs is sampled by the filter
+  Uint32 *zero = calloc((size_t)GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE, sizeof(Uint32));
+  if (zero) {
+    SDL_UpdateTexture(pg->texture, NULL, zero, GLYPH_PAGE_SIZE * sizeof(Uint32));
+    free(zero);
+  }
+  batch_init(&pg->batch, pg->texture, 256);
+  return g->npages++;
+}
+
+//room for a w x h glyph, in a new page while there may be more, else in
+//place of the page drawn from longest ago
+static int glyph_place(GlyphCache *g, int w, int h, int *x, int *y) {
+  for (int k = 0; k < g->npages; k++) {
+    if (glyph_page_pack(&g->pages[k], w, h, x, y)) return k;
+  }
+  if (g->npages < GLYPH_MAX_PAGES) {
+    int k = glyph_page_new(g);
+    if (k >= 0 && glyph_page_pack(&g->pages[k], w, h, x, y)) return k;
+  }
+  if (g->npages == 0) return -1;
+  int lru = 0;
+  for (int k = 1; k < g->npages; k++) {
+    if (g->pages[k].lastUse < g->pages[lru].lastUse) lru = k;
+  }
+  glyph_page_evict(g, lru);
+  return glyph_page_pack(&g->pages[lru], w, h, x, y) ? lru : -1;
+}
+
+const CharInfo* glyph_cache_get(GlyphCache *g, Uint32 cp) {
+  if (cp < 128) return &fontMap[cp];
+  if (g->count * 2 >= g->tableCap) glyph_table_grow(g);
+  CachedGlyph *slot = glyph_slot(g, cp);
+  if (slot->cp == cp) return &slot->info;
+  //misses are kept too, pointing at '?', so they cost one lookup next time
+  CharInfo info = fontMap['?'];
+  SDL_Surface *gs = TTF_FontHasGlyph(font, cp) ? TTF_RenderGlyph_Blended(font, cp, (SDL_Color){255, 255, 255, 255}) : NULL;
+  if (gs != NULL && gs->format != SDL_PIXELFORMAT_ARGB8888) {
+    SDL_Surface *conv = SDL_ConvertSurface(gs, SDL_PIXELFORMAT_ARGB8888);
+    SDL_DestroySurface(gs);
+    gs = conv;
+  }
+  if (gs != NULL) {
+    int x, y;
+    int k = glyph_place(g, gs->w, gs->h, &x, &y);
+    if (k >= 0) {
+      SDL_Rect r = {x, y, gs->w, gs->h};
+      SDL_UpdateTexture(g->pages[k].texture, &r, gs->pixels, gs->pitch);
+      info.ch = '?';
+      info.srcRect = (SDL_FRect){x, y, gs->w, gs->h};
+      info.width = gs->w;
+      info.page = k + 1;
+      g->rasterized++;
+      //an eviction rebuilt the table
+      slot = glyph_slot(g, cp);
+    }
+    SDL_DestroySurface(gs);
+  }
+  slot->cp = cp;
+  slot->info = info;
+  g->count++;
+  return &slot->info;
+}
+
+const CharInfo* glyph_at(const char *s, size_t n, size_t *i) {
+  Uint8 c = s[*i];
+  if (c < 0x80) {
+    (*i)++;
+    return &fontMap[c];
+  }
+  size_t k = utf8_seq_len(s, n, *i);
+  if (k == 0) {
+    (*i)++;
+    return glyph_cache_get(&glyphCache, 0xFFFD);
+  }
+  Uint32 cp = c & (0xFF >> (k + 1));
+  for (size_t j = 1; j < k; j++) cp = (cp << 6) | (s[*i + j] & 0x3F);
+  *i += k;
+  return glyph_cache_get(&glyphCache, cp);
+}
+
+void glyph_draw(const CharInfo *chInfo, float x, float y, Uint8 r, Uint8 g, Uint8 bl) {
+  if (chInfo->page == 0) {
+    batch_glyph(&glyphBatch, chInfo, x, y, r, g, bl);
+    return;
+  }
+  GlyphPage *pg = &glyphCache.pages[chInfo->page - 1];
+  pg->lastUse = glyphCache.frame;
+  batch_glyph(&pg->batch, chInfo, x, y, r, g, bl);
+}
+
+void glyphs_flush(void) {
+  batch_flush(&glyphBatch);
+  for (int k = 0; k < glyphCache.npages; k++) batch_flush(&glyphCache.pages[k].batch);
+}
+
+void glyph_cache_free(GlyphCache *g) {
+  for (int k = 0; k < g->npages; k++) {
+    batch_free(&g->pages[k].batch);
+    free(g->pages[k].shelves);
+    SDL_DestroyTexture(g->pages[k].texture);
+  }
+  free(g->table);
+  memset(g, 0, sizeof(*g));
+}
+///////////////////////////////////////////////////////////////
+
+//render CUSTOM text////////////////////////////////
+void renderTextA(String *s,int startX, int startY) {
+  int x = startX;
+  int y = startY;
+  for (size_t i = 0; i < s->length; ) {
+    const CharInfo* chInfo = glyph_at(s->data, s->length, &i);
+    glyph_draw(chInfo, x, y, 255, 255, 255);
+    x += chInfo->width; //
+  }
+}
+//////////////////////////////////////////////////////
+
+void CustomString_init(CustomString *s,int tn,int as,int x,int y) {
+  string_init(&s->str);
+  s->textSegs=tn;
+  s->possSegs = malloc(sizeof(int) * tn);
+  s->activeSegs = malloc(sizeof(int) * as);
+  s->XY[0] = x;
+  s->XY[1] = y;
+}
+
+void CustomString_Add(CustomString *s, const char *str, int tn, int n, int as,int XXX, int flag) { // flag 0-string 1-int
+  if(flag==0){
+    string_append_str(&s->str, str);
+    s->possSegs[n] = tn;
+    s->activeSegs[n] = as;
+  } else if (flag == 1) {
+    // string_append_str(&s->str, str);
+    char *ptr=getC(XXX);
+    string_append_str(&s->str, ptr);
+    free(ptr);
+    s->possSegs[n] = tn;
+    s->activeSegs[n] = as;
+  }
+}
+
+void CustomString_Update(CustomString *s,const char *str,int tn, int n, int as,int XXX,int flag) {
+  s->str.data[s->activeSegs[n]+1] = '\0';
+  s->str.length = strlen(s->str.data);
+  char *ptr=getC(XXX);
+  string_append_str(&s->str, ptr);
+  free(ptr);
+  s->possSegs[n] = tn;
+  s->activeSegs[n] = as;
+}
+
+
+void CustomString_Render(CustomString *s) {
+  renderTextA(&s->str, s->XY[0], s->XY[1]);//renderCustomLine
+}
+
+void CustomString_free(CustomString *s) {
+  string_free(&s->str);
+  free(s->possSegs);
+  free(s->activeSegs);
+  s->possSegs = NULL;
+  s->activeSegs=NULL;
+}
+
+void status_init(void) {
+  CustomString_init(&cstring, 4, 4, 0, 575);
+  CustomString_Add(&cstring, "Filename: ", 0, 0, 0, 0, 0);
+  CustomString_Add(&cstring, "OpenglSDL2Window5.c ", 1, 1, 9, 0, 0);
+  CustomString_Add(&cstring, "Chars: ", 2, 2, 9+strlen("OpenglSDL2Window5.c "), 0, 0);
+  CustomString_Add(&cstring,NULL,3,3,9+strlen("OpenglSDL2Window5.c Chars: "),buffer.totalSizeChars,1);
+
+  CustomString_init(&cstats, 2, 2, SCREEN_WIDTH - 14 * 8, TEXT_AREA_HEIGHT);
+  CustomString_Add(&cstats, "Draws: ", 0, 0, 0, 0, 0);
+  CustomString_Add(&cstats, NULL, 1, 1, strlen("Draws: ") - 1, 0, 1);
+
+  CustomString_init(&cload, 2, 2, SCREEN_WIDTH - 28 * 8, TEXT_AREA_HEIGHT);
+  CustomString_Add(&cload, "Loaded %: ", 0, 0, 0, 0, 0);
+  CustomString_Add(&cload, NULL, 1, 1, strlen("Loaded %: ") - 1, buffer_load_progress(&buffer), 1);
+
+  string_init(&gotoPrompt.status);
+  status_update();
+}
+
+void status_update(void) {
+  CustomString_Update(&cstring,NULL,3,3,9+strlen("OpenglSDL2Window5.c Chars: "),buffer.totalSizeChars,1);
+  //the cursor's offset comes from the line index, streamed files have none
+  size_t at;
+  if (buffer.totalBytes == 0 || cursor_Line >= buffer.nlines ||
+      buffer_line_offset(&buffer, cursor_Line, &at, NULL) != 0) {
+    return;
+  }
+  at += cursor_Pos;
+  string_append_str(&cstring.str, " At: ");
+  char *ptr = getC((int)(at >= buffer.totalBytes ? 100 : at * 100 / buffer.totalBytes));
+  string_append_str(&cstring.str, ptr);
+  free(ptr);
+  string_append_str(&cstring.str, "%");
+}
+
+void status_free(void) {
+  CustomString_free(&cstring);
+  CustomString_free(&cstats);
+  CustomString_free(&cload);
+  string_free(&gotoPrompt.status);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//init SDL SDL_ttf
+int initSDL(const char *driver) {
+
+    SDL_SetHint(SDL_HINT_X11_WINDOW_TYPE, "1");
+    if (driver) SDL_SetHint(SDL_HINT_VIDEO_DRIVER, driver);
+if (!SDL_Init(SDL_INIT_VIDEO)) {
+     SDL_Log("SDL_Init failed: %s", SDL_GetError());
+     return 0;
+}
+  if (!TTF_Init()) {
+    printf("TTF_Init Error: %s\n", SDL_GetError());
+    return 0;
+  }
+
+  //start info
+  int ww, hh;
+  getWindowGW(&ww);
+  getWindowGH(&hh);
+  int WindowW=(ww*FONT_SIZE);
+  int WindowH = (hh * FONT_SIZE);
+
+  if (!SDL_CreateWindowAndRenderer("Test",WindowW, WindowH,SDL_WINDOW_HIGH_PIXEL_DENSITY,&window, &renderer)) {
+    SDL_Log("SDL_CreateWindowAndRenderer failed: %s", SDL_GetError());
+    return 0;
+  }
+  return 1;
+}
+
+//create Texture Atlas
+int createFontAtlas() {
+  TTF_SetFontSDF(font,true);
+  font = TTF_OpenFont("consola.ttf", FONT_SIZE);
+  if (!font) {
+    printf("TTF_OpenFont Error: %s\n",SDL_GetError());
+    return 0;
+  }
+
+  // TTF_SetFontSizeDPI(font,10,96,96);
+  // TTF_SetFontKerning(font,true);
+  // this is just for debug time
+  //start
+  int fx,fy,mx,my,ma;
+  TTF_GetGlyphMetrics(font, 'S', &fx, &mx, &fy, &my, &ma);
+  fWidth = mx - fx;
+  fHeight = my - fy;
+  //SDL_Log("%d %d %d\n", fWidth, fHeight, ma);
+  //end
+  //render the glyphs first so the atlas is sized to them, one cell per
+  //glyph on a 16 wide grid instead of a fixed 784x784 float surface
+  SDL_Surface* glyphs[128] = {NULL};
+  int cellW = 1, cellH = 1;
+  for (int c = 32; c < 128; c++) {
+    glyphs[c] = TTF_RenderGlyph_Blended(font, c, (SDL_Color){255,255,255,255});
+    if (!glyphs[c]) {
+      printf("TTF_RenderGlyph_Blended Error: %s\n", SDL_GetError());
+      continue;
+    }
+    if (glyphs[c]->w + GLYPH_PAD > cellW) cellW = glyphs[c]->w + GLYPH_PAD;
+    if (glyphs[c]->h + GLYPH_PAD > cellH) cellH = glyphs[c]->h + GLYPH_PAD;
+  }
+  //white with coverage in alpha, vertex colour tints it, 4 bytes a pixel
+  int atlasWidth = 16 * cellW;
+  int atlasHeight = (128 - 32) / 16 * cellH;
+  atlasW = atlasWidth;
+  atlasH = atlasHeight;
+  SDL_Surface* surface = SDL_CreateSurface(atlasWidth,atlasHeight,SDL_PIXELFORMAT_ARGB8888);
+  if (!surface) {
+    printf("SDL_CreateRGBSurface Error: %s\n", SDL_GetError());
+    for (int c = 32; c < 128; c++) SDL_DestroySurface(glyphs[c]);
+    return 0;
+  }
+
+  SDL_FRect destRect;
+  //fill atlas
+  for (size_t c = 32; c < 128; c++) {
+    char32_t ch = c;
+    SDL_Surface* glyphSurface = glyphs[c];
+    if (!glyphSurface) continue;
+    int index = c - 32;
+    destRect.x= (index % 16) * cellW;
+    destRect.y= (index / 16) * cellH;
+    destRect.w= glyphSurface->w;
+    destRect.h= glyphSurface->h;
+
+    SDL_Rect temp;
+    temp.x =destRect.x;
+    temp.y =destRect.y;
+    temp.w =destRect.w;
+    temp.h =destRect.h;
+    SDL_BlitSurface(glyphSurface, NULL, surface, &temp);
+
+    //fill atlas
+    fontMap[c].ch = ch;
+    fontMap[c].srcRect = destRect;
+    fontMap[c].width = glyphSurface->w; //
+    fontMap[c].page = 0;
+    SDL_DestroySurface(glyphSurface);
+  }
+
+  //create texture from surface
+  fontAtlas = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_DestroySurface(surface);
+  if (!fontAtlas) {
+    printf("SDL_CreateTextureFromSurface Error: %s\n", SDL_GetError());
+    return 0;
+  }
+  return 1;
+}
+
+//init start text
+void initText() {
+  const char* initial = "Type to edit. Backspace to delete.";
+  string_init(&text);
+  string_append_str(&text, initial);
+}
+
+void scroll_to_cursor(void) {
+  if (wrapLines) {
+    //rows, the cursor row stays among the whole rows on screen
+    int x;
+    Sint64 y;
+    view_locate(cursor_Line, cursor_Pos, &x, &y);
+    Sint64 top = scrollY / FONT_SIZE;
+    Sint64 row = (y + scrollY) / FONT_SIZE;
+    int page = TEXT_AREA_HEIGHT / FONT_SIZE;
+    if (row < top) top = row;
+    else if (row >= top + page) top = row - page + 1;
+    scrollY = (int)top * FONT_SIZE;
+    return;
+  }
+  if ((int)cursor_Line > tempS) tempS = cursor_Line;
+  else if ((int)cursor_Line < tempS - 41) tempS = cursor_Line + 41;
+  scrollY = (tempS - 41) * FONT_SIZE;
+}
+
+//decimal number at *p, moves *p past it, returns 0 without digits
+static int goto_number(const char **p, const char *end, size_t *n) {
+  const char *q = *p;
+  *n = 0;
+  while (q < end && *q >= '0' && *q <= '9') *n = *n * 10 + (*q++ - '0');
+  if (q == *p) return 0;
+  *p = q;
+  return 1;
+}
+
+int goto_target(const Buffer *b, const char *input, size_t len, size_t *line, size_t *pos) {
+  const char *p = input;
+  const char *end = input + len;
+  size_t n;
+  if (b->nlines == 0) return 0;
+  if (p < end && *p == '@') {
+    p++;
+    return goto_number(&p, end, &n) && p == end && buffer_offset_line(b, n, line, pos) == 0;
+  }
+  if (!goto_number(&p, end, &n)) return 0;
+  if (p < end && *p == '%') {
+    if (++p != end || n > 100) return 0;
+    return buffer_offset_line(b, b->totalBytes / 100 * n + b->totalBytes % 100 * n / 100, line, pos) == 0;
+  }
+  size_t col = 1;
+  if (p < end && *p == ':') {
+    p++;
+    if (!goto_number(&p, end, &col)) return 0;
+  }
+  if (p != end) return 0;
+  *line = n == 0 ? 0 : n - 1 < b->nlines ? n - 1 : b->nlines - 1;
+  //column counts characters and stops in front of the line break
+  const String *s = buffer_get_line(b, *line);
+  size_t last = s->length;
+  if (last > 0 && s->data[last - 1] == '\n') last--;
+  size_t i = 0;
+  for (col = col > 0 ? col - 1 : 0; i < last; i++) {
+    if ((s->data[i] & 0xC0) == 0x80) continue;
+    if (col == 0) break;
+    col--;
+  }
+  *pos = i;
+  return 1;
+}
+
+static void goto_status(GotoPrompt *g) {
+  g->status.length = 0;
+  string_append_str(&g->status, "Go to: ");
+  string_append_len(&g->status, g->input, g->len);
+}
+
+//keys of the go to prompt, returns 1 when the event was used up
+static int handleGotoInput(SDL_Event *e) {
+  GotoPrompt *g = &gotoPrompt;
+  if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_G && (e->key.mod & SDL_KMOD_CTRL)) {
+    g->active = 1;
+    g->len = 0;
+  } else if (!g->active) {
+    return 0;
+  } else if (e->type == SDL_EVENT_TEXT_INPUT) {
+    size_t n = strlen(e->text.text);
+    if (g->len + n > GOTO_MAX_INPUT) return 1;
+    memcpy(g->input + g->len, e->text.text, n);
+    g->len += n;
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_BACKSPACE) {
+    if (g->len > 0) g->len = utf8_prev(g->input, g->len);
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_RETURN) {
+    size_t line, pos;
+    g->active = 0;
+    if (goto_target(&buffer, g->input, g->len, &line, &pos)) {
+      cursor_Line = line;
+      cursor_Pos = pos;
+      undo_seal(&buffer.undo);
+      scroll_to_cursor();
+    }
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_ESCAPE) {
+    g->active = 0;
+  } else if (e->type == SDL_EVENT_KEY_DOWN) {
+    //any other key closes the prompt and does its usual thing
+    g->active = 0;
+    return 0;
+  } else {
+    return 0;
+  }
+  goto_status(g);
+  return 1;
+}
+
+//keys of the find prompt, returns 1 when the event was used up
+static int handleSearchInput(SDL_Event *e) {
+  size_t line = cursor_Line;
+  size_t pos = cursor_Pos;
+  int found = 0;
+  int shift = e->type == SDL_EVENT_KEY_DOWN && (e->key.mod & SDL_KMOD_SHIFT);
+  if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_F && (e->key.mod & SDL_KMOD_CTRL)) {
+    if (search.active) {
+      found = search_jump(&search, 1, &line, &pos);
+    } else {
+      //reopen with the last query, typing refines it from the cursor
+      search.active = 1;
+      search.originLine = cursor_Line;
+      search.originPos = cursor_Pos;
+      search_set_query(&search, &buffer, search.query, search.qlen);
+      found = search_poll(&search, &line, &pos);
+    }
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_F3) {
+    found = search_jump(&search, shift ? -1 : 1, &line, &pos);
+  } else if (!search.active) {
+    return 0;
+  } else if (e->type == SDL_EVENT_TEXT_INPUT) {
+    size_t n = strlen(e->text.text);
+    if (search.qlen + n > SEARCH_MAX_QUERY) return 1;
+    char q[SEARCH_MAX_QUERY];
+    memcpy(q, search.query, search.qlen);
+    memcpy(q + search.qlen, e->text.text, n);
+    search_set_query(&search, &buffer, q, search.qlen + n);
+    found = search_poll(&search, &line, &pos);
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_BACKSPACE) {
+    size_t n = search.qlen;
+    //drop a whole UTF-8 sequence
+    while (n > 0 && (search.query[--n] & 0xC0) == 0x80) {}
+    search_set_query(&search, &buffer, search.query, n);
+    found = search_poll(&search, &line, &pos);
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_RETURN) {
+    found = search_jump(&search, shift ? -1 : 1, &line, &pos);
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_R && (e->key.mod & SDL_KMOD_CTRL)) {
+    search.regex = !search.regex;
+    search_set_query(&search, &buffer, search.query, search.qlen);
+    found = search_poll(&search, &line, &pos);
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_ESCAPE) {
+    search.active = 0;
+    search_clear(&search);
+  } else if (e->type == SDL_EVENT_KEY_DOWN) {
+    //any other key closes the prompt, matches stay highlighted
+    search.active = 0;
+    return 0;
+  } else {
+    return 0;
+  }
+  if (found) {
+    cursor_Line = line;
+    cursor_Pos = pos;
+    scroll_to_cursor();
+  }
+  return 1;
+}
+
+//events that change the text, hits from before would point at wrong places
+static int isEditEvent(const SDL_Event *e) {
+  if (e->type == SDL_EVENT_TEXT_INPUT) return 1;
+  if (e->type != SDL_EVENT_KEY_DOWN) return 0;
+  SDL_Keycode k = e->key.key;
+  return k == SDLK_BACKSPACE || k == SDLK_TAB || k == SDLK_RETURN ||
+         ((k == SDLK_Z || k == SDLK_Y || k == SDLK_V) && (e->key.mod & SDL_KMOD_CTRL));
+}
+
+//clipboard text at the cursor in one bulk insert, the cursor ends behind it
+static void paste_clipboard(void) {
+  char *t = replaying ? SDL_strdup(replayClipboard ? replayClipboard : "") : SDL_GetClipboardText();
+  size_t n = t ? strlen(t) : 0;
+  const String *line = buffer_get_line(&buffer, cursor_Line);
+  //text goes in front of the line break, so does the cursor
+  if (cursor_Pos == line->length && cursor_Pos > 0 && line->data[cursor_Pos - 1] == '\n') cursor_Pos--;
+  //a paste is an undo step of its own
+  undo_seal(&buffer.undo);
+  if (n > 0 && buffer_edit_insert(&buffer, cursor_Line, cursor_Pos, t, n) == 0) {
+    undo_seal(&buffer.undo);
+    size_t nl = simd.count_newlines(t, n);
+    if (nl == 0) {
+      cursor_Pos += n;
+    } else {
+      const char *last = t + n;
+      while (last[-1] != '\n') last--;
+      cursor_Line += nl;
+      cursor_Pos = t + n - last;
+    }
+    scroll_to_cursor();
+  }
+  SDL_free(t);
+}
+
+//there is no selection, copy takes the cursor line with its line break
+static void copy_line(void) {
+  const String *line = buffer_get_line(&buffer, cursor_Line);
+  char *t = malloc(line->length + 1);
+  if (t == NULL) return;
+  buffer_copy_range(&buffer, cursor_Line, 0, line->length, t);
+  t[line->length] = '\0';
+  if (!SDL_SetClipboardText(t)) SDL_Log("Copy failed: %s", SDL_GetError());
+  free(t);
+}
+
+//column Up and Down aim for over short lines, SIZE_MAX takes the cursor's
+static size_t cursorGoal = SIZE_MAX;
+
+//cursor to the same column on another line
+static void cursor_to_line(size_t line) {
+  if (cursorGoal == SIZE_MAX) cursorGoal = line_column(buffer_get_line_info(&buffer, cursor_Line), cursor_Pos);
+  cursor_Line = line;
+  cursor_Pos = line_pos_at_column(buffer_get_line_info(&buffer, cursor_Line), cursorGoal);
+}
+
+//work with input
+void handleInput(SDL_Event* e,SDL_Renderer *renderer) {
+  if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_F12) {
+    prof_toggle(&prof);
+    return;
+  }
+  if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_Z && (e->key.mod & SDL_KMOD_ALT)) {
+    view_set_wrap(!wrapWanted);
+    return;
+  }
+  if (e->type == SDL_EVENT_KEY_DOWN && (e->key.mod & SDL_KMOD_CTRL) && fileTabs.ntabs > 1 &&
+      (e->key.key == SDLK_TAB || e->key.key == SDLK_PAGEUP || e->key.key == SDLK_PAGEDOWN)) {
+    tabs_cycle(e->key.key == SDLK_PAGEUP || (e->key.mod & SDL_KMOD_SHIFT) ? -1 : 1);
+    return;
+  }
+  //the keys below scroll by lines, wrapped views follow the cursor by rows instead
+  int wrapScroll = scrollY;
+  if (e->type == SDL_EVENT_TEXT_INPUT ||
+      (e->type == SDL_EVENT_KEY_DOWN && e->key.key != SDLK_UP && e->key.key != SDLK_DOWN &&
+       e->key.key != SDLK_PAGEUP && e->key.key != SDLK_PAGEDOWN)) {
+    cursorGoal = SIZE_MAX;
+  }
+  if (buffer.nlines == 0) return; //loader or streaming scan has not produced lines yet
+  buffer.undo.now = e->common.timestamp;
+  if (handleGotoInput(e)) return;
+  if (handleSearchInput(e)) return;
+  if (search.nchunks > 0 && isEditEvent(e)) search_clear(&search);
+  if (e->type == SDL_EVENT_TEXT_INPUT) {
+    if (textLength < MAX_TEXT_LENGTH - 1) {
+      //the whole composed text, one event can carry several codepoints
+      size_t n = strlen(e->text.text);
+      buffer_edit_insert(&buffer, cursor_Line, cursor_Pos, e->text.text, n);
+      cursor_Pos += n;
+    }
+  }
+  else if (e->type == SDL_EVENT_KEY_DOWN) {
+    //moving past the loaded lines only waits for the lines moved to
+    if (e->key.key == SDLK_DOWN) buffer_wait_lines(&buffer, cursor_Line + 2);
+    else if (e->key.key == SDLK_PAGEDOWN) buffer_wait_lines(&buffer, cursor_Line + 42);
+    //cursor moves end the current undo step
+    if (e->key.key == SDLK_HOME || e->key.key == SDLK_END || e->key.key == SDLK_LEFT ||
+        e->key.key == SDLK_RIGHT || e->key.key == SDLK_UP || e->key.key == SDLK_DOWN ||
+        e->key.key == SDLK_PAGEUP || e->key.key == SDLK_PAGEDOWN) {
+      undo_seal(&buffer.undo);
+    }
+    if (e->key.key == SDLK_S && (e->key.mod & SDL_KMOD_CTRL)) {
+      //a replay saving over its input would not start from the same text again
+      if (buffer.path && !replaying) buffer_save(&buffer, buffer.path);
+    } else if (e->key.key == SDLK_Z && (e->key.mod & SDL_KMOD_CTRL)) {
+      int moved = (e->key.mod & SDL_KMOD_SHIFT) ? buffer_redo(&buffer, &cursor_Line, &cursor_Pos)
+                                                : buffer_undo(&buffer, &cursor_Line, &cursor_Pos);
+      if (moved) scroll_to_cursor();
+    } else if (e->key.key == SDLK_Y && (e->key.mod & SDL_KMOD_CTRL)) {
+      if (buffer_redo(&buffer, &cursor_Line, &cursor_Pos)) scroll_to_cursor();
+    } else if (e->key.key == SDLK_V && (e->key.mod & SDL_KMOD_CTRL)) {
+      paste_clipboard();
+    } else if (e->key.key == SDLK_C && (e->key.mod & SDL_KMOD_CTRL)) {
+      copy_line();
+    } else if (e->key.key == SDLK_BACKSPACE && cursor_Line >= 0 && cursor_Pos >=0) {
+      if(cursor_Pos == 0){
+      } else {
+        //one codepoint, a combining mark goes without its base
+        size_t from = utf8_prev(buffer_get_line(&buffer, cursor_Line)->data, cursor_Pos);
+        buffer_edit_delete(&buffer, cursor_Line, from, cursor_Pos - from);
+        //CustomString_Update(&cstring,NULL,3,3,9+strlen("OpenglSDL2Window5.c Chars: "),buffer.totalSizeChars,1);
+        cursor_Pos = from;
+      }
+    } else if (e->key.key == SDLK_HOME) {
+      cursor_Pos = 0;
+
+    } else if (e->key.key == SDLK_END) {
+      cursor_Pos=buffer_get_line(&buffer, cursor_Line)->length;
+    }
+    else if(e->key.key == SDLK_TAB){
+      buffer_edit_insert(&buffer, cursor_Line, cursor_Pos, "  ", 2);
+      cursor_Pos+=2;
+    }
+    else if(e->key.key == SDLK_RETURN){
+      buffer_edit_insert(&buffer, cursor_Line, cursor_Pos, "\n", 1);
+      cursor_Line++;
+      cursor_Pos = 0;
+    }
+    else if(e->key.key == SDLK_PAGEUP){
+      if (cursor_Line - 41 > 0 && cursor_Line - 41 < buffer.nlines) {
+        scrollY-=FONT_SIZE*41;
+        cursor_to_line(cursor_Line - 41);
+        tempS-=41;
+      }
+    } else if (e->key.key == SDLK_PAGEDOWN) {
+      if (cursor_Line + 41 < buffer.nlines) {
+        scrollY+=FONT_SIZE*41;
+        cursor_to_line(cursor_Line + 41);
+        tempS+=41;
+      }
+    }
+    else if (e->key.key == SDLK_LEFT && cursor_Pos > 0) {
+      const String *line = buffer_get_line(&buffer, cursor_Line);
+      cursor_Pos = utf8_prev_grapheme(line->data, line->length, cursor_Pos);
+      //printf("%d %d\n",cursor_Pos,cursor_Line);
+    }
+    else if (e->key.key == SDLK_RIGHT && cursor_Pos < buffer_get_line(&buffer, cursor_Line)->length) {
+      const String *line = buffer_get_line(&buffer, cursor_Line);
+      cursor_Pos = utf8_next_grapheme(line->data, line->length, cursor_Pos);
+      //printf("%d %d\n",cursor_Pos,cursor_Line);
+    }
+    else if (e->key.key == SDLK_UP && cursor_Line > 0) {
+      if (cursor_Line - 1 < tempS-41) {
+        scrollY-=FONT_SIZE;
+        tempS--;
+
+      }
+      cursor_to_line(cursor_Line - 1);
+      //printf("%d\n",cursor_Line);
+      //printf("%d %d\n",cursor_Pos,cursor_Line);
+    }
+    else if (e->key.key == SDLK_DOWN && cursor_Line < buffer.nlines - 1) {
+
+      if (cursor_Line + 1 > tempS) {
+        scrollY+=FONT_SIZE;
+        tempS++;
+      }
+      cursor_to_line(cursor_Line + 1);
+      //printf("%d\n",cursor_Line);
+      //printf("%d %d\n",cursor_Pos,cursor_Line);
+    }
+  }
+  if (wrapLines) {
+    scrollY = wrapScroll;
+    scroll_to_cursor();
+  }
+  status_update();
+}
+
+//boxes behind visible matches, the glyph batch is drawn over them later,
+//one fill call for all matches and one for the match at the cursor
+static void renderSearchHits(int startX, int startY, int first, int last) {
+  SDL_FRect rects[256];
+  SDL_FRect cur;
+  int n = 0;
+  int haveCur = 0;
+  for (int j = first; j < last && n < 256; j++) {
+    size_t nh;
+    const SearchHit *h = search_line_hits(&search, j, &nh);
+    if (nh == 0) continue;
+    for (size_t k = 0; k < nh && n < 256; k++) {
+      int x0, x1;
+      Sint64 y0, y1;
+      view_locate(j, h[k].pos, &x0, &y0);
+      view_locate(j, h[k].pos + h[k].len, &x1, &y1);
+      //a match cut by a wrap is marked to the end of its first row
+      if (y1 != y0) x1 = SCREEN_WIDTH;
+      x0 += startX;
+      x1 += startX;
+      if (x1 <= 0 || x0 >= SCREEN_WIDTH || y0 >= TEXT_AREA_HEIGHT || y0 + FONT_SIZE <= 0) continue;
+      SDL_FRect r = {x0, startY + y0, x1 - x0, FONT_SIZE};
+      if ((size_t)j == cursor_Line && h[k].pos == cursor_Pos) {
+        cur = r;
+        haveCur = 1;
+      } else {
+        rects[n++] = r;
+      }
+    }
+  }
+  if (n > 0) {
+    SDL_SetRenderDrawColor(renderer, 90, 80, 20, 255);
+    SDL_RenderFillRects(renderer, rects, n);
+    frameDrawCalls++;
+  }
+  if (haveCur) {
+    SDL_SetRenderDrawColor(renderer, 170, 120, 0, 255);
+    SDL_RenderFillRect(renderer, &cur);
+    frameDrawCalls++;
+  }
+}
+
+//rows of the view, lines in [first, last) without a layout get one and
+//the view is looked up again until it stops changing
+static void view_rows(int *first, int *last) {
+  size_t top = scrollY > 0 ? scrollY / FONT_SIZE : 0;
+  size_t bottom = (scrollY + TEXT_AREA_HEIGHT - 1) / FONT_SIZE;
+  size_t line, row;
+  *first = 0;
+  *last = 0;
+  if (buffer_row_line(&buffer, top, &line, &row) != 0) return;
+  //the top line measured may end above the view
+  wrap_layout(line);
+  buffer_row_line(&buffer, top, &line, &row);
+  *first = line;
+  for (size_t j = line; ; j++) {
+    buffer_row_line(&buffer, bottom, &line, &row);
+    *last = line + 1;
+    if (j >= line) break;
+    wrap_layout(j);
+  }
+  wrap_layout(line);
+}
+
+void view_lines(int *first, int *last) {
+  if (wrapLines) {
+    view_rows(first, last);
+    return;
+  }
+  *first = scrollY > 0 ? scrollY / FONT_SIZE : 0;
+  *last = (scrollY + TEXT_AREA_HEIGHT + FONT_SIZE - 1) / FONT_SIZE;
+  if (*last > (int)buffer.nlines) *last = buffer.nlines;
+}
+
+//glyphs of bytes [i, end) of a line starting at x, up to the right edge
+static void renderRun(const Line *info, size_t i, size_t end, int x, int y) {
+  const String *line = &info->text;
+  const SynSpan *sp = info->spans;
+  const SynSpan *spEnd = sp + info->nspans;
+  //first span not over before i
+  size_t lo = 0;
+  size_t hi = info->nspans;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (sp[mid].start + sp[mid].len <= i) lo = mid + 1;
+    else hi = mid;
+  }
+  sp += lo;
+  while (i < end) {
+    const char c = line->data[i];
+    if (x >= SCREEN_WIDTH) break; //rest of the line is right of the view
+    if(c=='\n'||c==10){
+      break;
+    }
+    if (c == '\t') {
+      x += TAB_WIDTH * fontMap[' '].width;
+      i++;
+      continue;
+    }
+    size_t at = i;
+    const CharInfo* chInfo = glyph_at(line->data, line->length, &i);
+    //glyphs left of the view are not drawn
+    if (x + chInfo->width > 0) {
+      while (sp < spEnd && (Uint32)at >= sp->start + sp->len) sp++;
+      int kind = (sp < spEnd && (Uint32)at >= sp->start) ? sp->kind : SYN_TEXT;
+      glyph_draw(chInfo, x, y, synColors[kind][0], synColors[kind][1], synColors[kind][2]);
+    }
+    x += chInfo->width; //
+  }
+}
+
+//rows on screen of lines [from, to), long lines draw only their visible rows
+static void renderRows(int startX, int startY, int from, int to) {
+  Sint64 y = view_line_y(from);
+  for (int j = from; j < to && y < TEXT_AREA_HEIGHT; j++) {
+    const Line *info = buffer_get_line_info(&buffer, j);
+    const WrapEntry *e = wrap_layout(j);
+    size_t r = y < 0 ? (size_t)(-y / FONT_SIZE) : 0;
+    for (; r <= e->nstarts && y + (Sint64)r * FONT_SIZE < TEXT_AREA_HEIGHT; r++) {
+      size_t i = r > 0 ? e->starts[r - 1] : 0;
+      size_t end = r < e->nstarts ? e->starts[r] : info->text.length;
+      renderRun(info, i, end, startX, startY + (int)(y + (Sint64)r * FONT_SIZE));
+    }
+    y += (Sint64)(e->nstarts + 1) * FONT_SIZE;
+  }
+}
+
+//render text
+void renderText(int startX, int startY, int from, int to) {
+  if (from >= to) return;
+  renderSearchHits(startX, startY, from, to);
+  if (wrapLines) {
+    renderRows(startX, startY, from, to);
+    return;
+  }
+  for (int j = from; j < to; j++) {
+    Line *info = buffer_get_line_info(&buffer, j);
+    int x = startX - scrollX;
+    int y = startY - scrollY + j * FONT_SIZE;
+    //long lines scrolled sideways start at the last mark left of the view
+    int skipX = 0;
+    size_t i = scrollX > startX ? line_seek_x(info, scrollX - startX, &skipX) : 0;
+    renderRun(info, i, info->text.length, x + skipX, y);
+  }
+}
+
+///////////////////////////////////////////////////////////////
+//column cache
+//columns of p[0,n), codepoints with tabs TAB_WIDTH wide
+static size_t col_span(const char *p, size_t n) {
+  size_t col = simd.count_utf8(p, n);
+  for (const char *t = memchr(p, '\t', n); t; t = memchr(t + 1, '\t', p + n - t - 1)) {
+    col += TAB_WIDTH - 1;
+  }
+  return col;
+}
+
+//pixels of bytes [from, to), same advances renderText uses
+static int col_pixels(const String *s, size_t from, size_t to) {
+  int x = 0;
+  for (size_t i = from; i < to; ) {
+    const char c = s->data[i];
+    if (c == '\n') break;
+    if (c == '\t') {
+      x += TAB_WIDTH * fontMap[' '].width;
+      i++;
+      continue;
+    }
+    x += glyph_at(s->data, s->length, &i)->width;
+  }
+  return x;
+}
+
+void col_forget(const Line *l) {
+  for (int k = 0; k < COL_CACHE_LINES; k++) {
+    if (colCache.entries[k].line == l) colCache.entries[k].line = NULL;
+  }
+}
+
+void col_forget_pool(const LinePool *p) {
+  for (int k = 0; k < COL_CACHE_LINES; k++) {
+    if (colCache.entries[k].line && pool_owns(p, colCache.entries[k].line)) colCache.entries[k].line = NULL;
+  }
+}
+
+void col_cache_free(void) {
+  for (int k = 0; k < COL_CACHE_LINES; k++) free(colCache.entries[k].marks);
+  memset(&colCache, 0, sizeof(colCache));
+}
+
+//marks of l, built on first use, NULL for short lines
+static ColEntry* col_entry(const Line *l, int needX) {
+  const String *s = &l->text;
+  if (s->length < COL_MIN_LINE) return NULL;
+  ColEntry *e = NULL;
+  for (int k = 0; k < COL_CACHE_LINES && e == NULL; k++) {
+    if (colCache.entries[k].line == l) e = &colCache.entries[k];
+  }
+  if (e == NULL) {
+    //free slot or the least recently used one
+    e = &colCache.entries[0];
+    for (int k = 1; k < COL_CACHE_LINES && e->line != NULL; k++) {
+      ColEntry *c = &colCache.entries[k];
+      if (c->line == NULL || c->lastUse < e->lastUse) e = c;
+    }
+    size_t need = s->length / COL_STRIDE + 1;
+    if (need > e->cap) {
+      ColMark *m = realloc(e->marks, sizeof(ColMark) * need);
+      if (m == NULL) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      e->marks = m;
+      e->cap = need;
+    }
+    //marks sit on cluster starts past every stride, columns come from the
+    //vector codepoint count of each stride
+    size_t pos = 0;
+    size_t col = 0;
+    e->nmarks = 0;
+    while (pos < s->length && e->nmarks < e->cap) {
+      e->marks[e->nmarks].pos = pos;
+      e->marks[e->nmarks].col = col;
+      e->marks[e->nmarks].x = 0;
+      e->nmarks++;
+      size_t next = pos + COL_STRIDE;
+      if (next >= s->length) break;
+      while (next < s->length && (s->data[next] & 0xC0) == 0x80) next++;
+      while (next < s->length && !utf8_cluster_start(s->data, s->length, next)) {
+        size_t k;
+        utf8_decode(s->data, s->length, next, &k);
+        next += k;
+      }
+      col += col_span(s->data + pos, next - pos);
+      pos = next;
+    }
+    e->line = l;
+    e->hasX = 0;
+  }
+  if (needX && !e->hasX) {
+    for (size_t k = 1; k < e->nmarks; k++) {
+      e->marks[k].x = e->marks[k - 1].x + col_pixels(s, e->marks[k - 1].pos, e->marks[k].pos);
+    }
+    e->hasX = 1;
+  }
+  e->lastUse = ++colCache.clock;
+  return e;
+}
+
+//last mark at or before byte pos
+static const ColMark* col_mark_at(const ColEntry *e, size_t pos) {
+  size_t k = pos / COL_STRIDE < e->nmarks ? pos / COL_STRIDE : e->nmarks - 1;
+  //marks run at most a cluster past their stride
+  while (k > 0 && e->marks[k].pos > pos) k--;
+  return &e->marks[k];
+}
+
+size_t line_column(const Line *l, size_t pos) {
+  const String *s = &l->text;
+  if (pos > s->length) pos = s->length;
+  const ColEntry *e = col_entry(l, 0);
+  const ColMark *m = e ? col_mark_at(e, pos) : NULL;
+  size_t from = m ? m->pos : 0;
+  return (m ? m->col : 0) + col_span(s->data + from, pos - from);
+}
+
+size_t line_pos_at_column(const Line *l, size_t col) {
+  const String *s = &l->text;
+  size_t last = s->length;
+  if (last > 0 && s->data[last - 1] == '\n') last--;
+  if (last > 0 && s->data[last - 1] == '\r') last--;
+  size_t i = 0;
+  size_t c = 0;
+  const ColEntry *e = col_entry(l, 0);
+  if (e) {
+    size_t lo = 0;
+    size_t hi = e->nmarks;
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      if (e->marks[mid].col <= col) lo = mid;
+      else hi = mid;
+    }
+    i = e->marks[lo].pos;
+    c = e->marks[lo].col;
+  }
+  while (i < last) {
+    size_t next = utf8_next_grapheme(s->data, last, i);
+    size_t w = col_span(s->data + i, next - i);
+    if (c + w > col) break;
+    c += w;
+    i = next;
+  }
+  return i;
+}
+
+int line_pixel_x(const Line *l, size_t pos) {
+  const String *s = &l->text;
+  size_t end = pos < s->length ? pos : s->length;
+  const ColEntry *e = col_entry(l, 1);
+  const ColMark *m = e ? col_mark_at(e, end) : NULL;
+  return m ? m->x + col_pixels(s, m->pos, end) : col_pixels(s, 0, end);
+}
+
+size_t line_seek_x(const Line *l, int x, int *markX) {
+  *markX = 0;
+  const ColEntry *e = col_entry(l, 1);
+  if (e == NULL) return 0;
+  size_t lo = 0;
+  size_t hi = e->nmarks;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (e->marks[mid].x <= x) lo = mid;
+    else hi = mid;
+  }
+  *markX = e->marks[lo].x;
+  return e->marks[lo].pos;
+}
+
+///////////////////////////////////////////////////////////////
+//soft wrap
+static size_t wrap_set(const Line *l) {
+  Uint64 h = (Uint64)(uintptr_t)l * 0x9E3779B97F4A7C15ULL;
+  return (size_t)(h >> 32) % WRAP_SETS * WRAP_WAYS;
+}
+
+void wrap_forget(const Line *l) {
+  WrapEntry *set = &wrapCache.entries[wrap_set(l)];
+  for (int k = 0; k < WRAP_WAYS; k++) {
+    if (set[k].line == l) set[k].line = NULL;
+  }
+}
+
+void wrap_forget_pool(const LinePool *p) {
+  for (int k = 0; k < WRAP_SETS * WRAP_WAYS; k++) {
+    if (wrapCache.entries[k].line && pool_owns(p, wrapCache.entries[k].line)) wrapCache.entries[k].line = NULL;
+  }
+}
+
+void wrap_cache_free(void) {
+  for (int k = 0; k < WRAP_SETS * WRAP_WAYS; k++) free(wrapCache.entries[k].starts);
+  memset(&wrapCache, 0, sizeof(wrapCache));
+}
+
+static void wrap_add_start(WrapEntry *e, size_t pos) {
+  if (e->nstarts == e->cap) {
+    size_t new_cap = e->cap ? e->cap * 2 : 16;
+    Uint32 *starts = realloc(e->starts, sizeof(Uint32) * new_cap);
+    if (starts == NULL) {
+      fprintf(stderr, "Memory reallocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    e->starts = starts;
+    e->cap = new_cap;
+  }
+  e->starts[e->nstarts++] = (Uint32)pos;
+}
+
+//same advances renderText uses, zero width marks never start a row
+static void wrap_measure(WrapEntry *e, const String *s) {
+  int width = SCREEN_WIDTH - WRAP_MARGIN;
+  int x = 0;
+  e->nstarts = 0;
+  for (size_t i = 0; i < s->length; ) {
+    const char c = s->data[i];
+    if (c == '\n') break;
+    size_t at = i;
+    int w;
+    if (c == '\t') {
+      w = TAB_WIDTH * fontMap[' '].width;
+      i++;
+    } else {
+      w = glyph_at(s->data, s->length, &i)->width;
+    }
+    if (x + w > width && w > 0 && x > 0) {
+      wrap_add_start(e, at);
+      x = 0;
+    }
+    x += w;
+  }
+}
+
+const WrapEntry* wrap_layout(size_t index) {
+  Line *l = buffer_get_line_info(&buffer, index);
+  static const WrapEntry none = {0};
+  if (l == NULL) return &none;
+  WrapEntry *set = &wrapCache.entries[wrap_set(l)];
+  WrapEntry *e = NULL;
+  for (int k = 0; k < WRAP_WAYS && e == NULL; k++) {
+    if (set[k].line == l) e = &set[k];
+  }
+  if (e == NULL) {
+    //free way or the least recently used one
+    e = &set[0];
+    for (int k = 1; k < WRAP_WAYS && e->line != NULL; k++) {
+      if (set[k].line == NULL || set[k].lastUse < e->lastUse) e = &set[k];
+    }
+    wrap_measure(e, &l->text);
+    e->line = l;
+    buffer_set_line_rows(&buffer, index, e->nstarts + 1);
+  }
+  e->lastUse = ++wrapCache.clock;
+  return e;
+}
+
+int view_set_wrap(int on) {
+  if (on && fontMap[' '].width <= 0) return -1;
+  wrapWanted = on;
+  size_t cols = on ? (SCREEN_WIDTH - WRAP_MARGIN) / fontMap[' '].width : 0;
+  int first, last;
+  view_lines(&first, &last);
+  if (buffer_set_wrap(&buffer, cols) != 0) return -1;
+  //rows were estimated again, measured counts go with the entries
+  wrap_cache_free();
+  wrapLines = on;
+  scrollX = 0;
+  if (on) {
+    size_t row;
+    buffer_line_row(&buffer, first, &row);
+    scrollY = (int)row * FONT_SIZE;
+  } else {
+    scrollY = first * FONT_SIZE;
+    tempS = first + 41;
+  }
+  scroll_to_cursor();
+  return 0;
+}
+
+Sint64 view_line_y(size_t line) {
+  if (!wrapLines) return (Sint64)line * FONT_SIZE - scrollY;
+  size_t row = line;
+  buffer_line_row(&buffer, line, &row);
+  return (Sint64)row * FONT_SIZE - scrollY;
+}
+
+void view_locate(size_t line, size_t pos, int *x, Sint64 *y) {
+  const Line *l = buffer_get_line_info(&buffer, line);
+  *y = view_line_y(line);
+  if (l == NULL) {
+    *x = 0;
+    return;
+  }
+  if (!wrapLines) {
+    *x = line_pixel_x(l, pos) - scrollX;
+    return;
+  }
+  //row of pos, a position on a row start belongs to that row
+  const WrapEntry *e = wrap_layout(line);
+  size_t lo = 0;
+  size_t hi = e->nstarts;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (e->starts[mid] <= pos) lo = mid + 1;
+    else hi = mid;
+  }
+  size_t from = lo > 0 ? e->starts[lo - 1] : 0;
+  *x = col_pixels(&l->text, from, pos < l->text.length ? pos : l->text.length);
+  *y += (Sint64)lo * FONT_SIZE;
+}
+///////////////////////////////////////////////////////////////
+
+//update char and pos
+void updateCharAt(int index, char newChar) {
+  if (index < 0 || index >= textLength) return;
+}
+
+void initPanel(Panel *p) {
+  int atlasWidth = 800;
+  int atlasHeight = 25;
+  SDL_Surface* surface =SDL_CreateSurface(atlasWidth,atlasHeight,SDL_PIXELFORMAT_RGBA32);
+
+  SDL_FillSurfaceRect( surface,NULL,SDL_MapSurfaceRGBA(surface, 255, 255, 255, 150)); // Fill with red//255, 255, 255, 150
+  p->panelTexture = SDL_CreateTextureFromSurface(renderer, surface);
+
+  SDL_DestroySurface(surface);
+}
+
+void renderPanel(SDL_Renderer *renderer,Panel *p,int x,int y){
+  SDL_FRect dstRect = {0,575,800,FONT_SIZE*2}; // 14
+  SDL_RenderTexture(renderer,p->panelTexture,NULL, &dstRect);
+  frameDrawCalls++;
+}
+
+void freePanel(Panel *p) {
+  SDL_DestroyTexture(p->panelTexture);
+}
+
+void initCursor(Cursor *c){
+  int atlasWidth = 16;
+  int atlasHeight = 24;
+  SDL_Surface* surface =SDL_CreateSurface(atlasWidth,atlasHeight,SDL_PIXELFORMAT_RGBA32);
+
+  SDL_FillSurfaceRect(surface, NULL,SDL_MapSurfaceRGBA(surface, 255, 255, 255, 255)); // Fill with red
+  c->cursorTexture = SDL_CreateTextureFromSurface(renderer, surface);
+
+  SDL_DestroySurface(surface);
+
+}
+
+void renderCursor(SDL_Renderer* renderer,Cursor *c,int x,int y){
+  // SDL_Rect dstRect = { x*13, y*24,13,23 };//24
+  int px;
+  Sint64 py;
+  view_locate(y, x, &px, &py);
+  SDL_FRect dstRect = {px, py, 9, FONT_SIZE}; // 14//need understand how to calculate actual size cursor
+  SDL_RenderTexture(renderer,c->cursorTexture,NULL, &dstRect);
+  frameDrawCalls++;
+}
+
+void freeCursor(Cursor *c){
+  SDL_DestroyTexture(c->cursorTexture);
+}
+
+///////////////////////////////////////////////////////////////
+//damage tracking
+static Uint64 damage_hash(Uint64 h, const void *p, size_t n) {
+  const unsigned char *s = p;
+  for (size_t i = 0; i < n; i++) h = (h ^ s[i]) * 1099511628211ULL;
+  return h;
+}
+
+//everything besides line text and cursor that changes what the text area shows
+static Uint64 damage_text_key(void) {
+  size_t v[7] = {search.active, search.regex, search.nchunks, search.ndone, search.nhits, search.qlen, wrapLines};
+  Uint64 h = damage_hash(14695981039346656037ULL, v, sizeof(v));
+  return damage_hash(h, search.query, search.qlen);
+}
+
+static Uint64 damage_status_key(void) {
+  int loading = buffer_load_progress(&buffer) < 100;
+  int v[3] = {search.active, gotoPrompt.active, loading};
+  Uint64 h = damage_hash(14695981039346656037ULL, v, sizeof(v));
+  if (gotoPrompt.active) h = damage_hash(h, gotoPrompt.status.data, gotoPrompt.status.length);
+  else if (search.active) h = damage_hash(h, search.status.data, search.status.length);
+  else h = damage_hash(h, cstring.str.data, cstring.str.length);
+  if (loading) h = damage_hash(h, cload.str.data, cload.str.length);
+  return h;
+}
+
+//pixel rows of lines [from, to] in the text area and the lines to draw there,
+//returns 0 when none of it is on screen
+static int damage_rect(size_t from, size_t to, int first, int last, SDL_Rect *r, int *drawFrom, int *drawTo) {
+  if (from >= (size_t)last && to != SIZE_MAX) return 0;
+  Sint64 y0 = from < (size_t)first ? 0 : view_line_y(from);
+  //to may be SIZE_MAX for everything below, test before adding 1
+  Sint64 y1 = to >= (size_t)last - 1 ? TEXT_AREA_HEIGHT : view_line_y(to + 1);
+  if (y0 < 0) y0 = 0;
+  if (y1 > TEXT_AREA_HEIGHT) y1 = TEXT_AREA_HEIGHT;
+  if (y0 >= y1) return 0;
+  r->x = 0;
+  r->y = (int)y0;
+  r->w = SCREEN_WIDTH;
+  r->h = (int)(y1 - y0);
+  *drawFrom = from > (size_t)first ? (int)from : first;
+  *drawTo = to >= (size_t)last - 1 ? last : (int)(to + 1);
+  return 1;
+}
+
+//status bar, clipped to r, the panel is blended over the strings
+static void renderStatus(const SDL_Rect *r, Panel *panel, int fill) {
+  SDL_SetRenderClipRect(renderer, r);
+  if (fill) {
+    SDL_FRect f = {r->x, r->y, r->w, r->h};
+    SDL_SetRenderDrawColor(renderer, 10, 10, 10, 255);
+    SDL_RenderFillRect(renderer, &f);
+    frameDrawCalls++;
+  }
+  PROF(PROF_STATUS, {
+    if (gotoPrompt.active) renderTextA(&gotoPrompt.status, 0, TEXT_AREA_HEIGHT);
+    else if (search.active) renderTextA(&search.status, 0, TEXT_AREA_HEIGHT);
+    else CustomString_Render(&cstring);
+    CustomString_Render(&cstats);
+    if (buffer_load_progress(&buffer) < 100) CustomString_Render(&cload);
+    glyphs_flush();
+  });
+  renderPanel(renderer, panel, 0, TEXT_AREA_HEIGHT);
+  SDL_SetRenderClipRect(renderer, NULL);
+}
+
+void damage_resize(void) {
+  int w, h;
+  damage.full = 1;
+  if (!SDL_GetRenderOutputSize(renderer, &w, &h)) return;
+  if (damage.target && damage.w == w && damage.h == h) return;
+  if (damage.target) SDL_DestroyTexture(damage.target);
+  damage.target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+  if (damage.target == NULL) {
+    SDL_Log("No render target, drawing whole frames: %s", SDL_GetError());
+    return;
+  }
+  //copied over the window as is
+  SDL_SetTextureBlendMode(damage.target, SDL_BLENDMODE_NONE);
+  damage.w = w;
+  damage.h = h;
+}
+
+void damage_free(void) {
+  if (damage.target) SDL_DestroyTexture(damage.target);
+  damage.target = NULL;
+}
+
+int renderFrame(Cursor *cursor, Panel *panel) {
+  int first, last;
+  view_lines(&first, &last);
+  //relex before looking at damage, lines whose colors changed add to it
+  if (first < last) syntax_update_view(&buffer, first, last - 1);
+
+  //goto and search jumps move the cursor outside handleInput
+  status_update();
+  Uint64 textKey = damage_text_key();
+  Uint64 statusKey = damage_status_key();
+  Uint64 statsKey = damage_hash(14695981039346656037ULL, cstats.str.data, cstats.str.length);
+  int text = damage.full || scrollX != damage.scrollX || scrollY != damage.scrollY || textKey != damage.textKey;
+  int status = damage.full || statusKey != damage.statusKey;
+
+  //line ranges to redraw: edited lines, where the cursor was and where it is
+  SDL_Rect rects[3];
+  int from[3], to[3];
+  int n = 0;
+  if (text) {
+    rects[0] = (SDL_Rect){0, 0, SCREEN_WIDTH, TEXT_AREA_HEIGHT};
+    from[0] = first;
+    to[0] = last;
+    n = 1;
+  } else {
+    if (buffer.damageFrom <= buffer.damageTo &&
+        damage_rect(buffer.damageFrom, buffer.damageTo, first, last, &rects[n], &from[n], &to[n])) n++;
+    if (cursor_Line != damage.cursorLine || cursor_Pos != damage.cursorPos) {
+      if (damage_rect(damage.cursorLine, damage.cursorLine, first, last, &rects[n], &from[n], &to[n])) n++;
+      if (damage_rect(cursor_Line, cursor_Line, first, last, &rects[n], &from[n], &to[n])) n++;
+    }
+  }
+  buffer.damageFrom = SIZE_MAX;
+  buffer.damageTo = 0;
+  damage.cursorLine = cursor_Line;
+  damage.cursorPos = cursor_Pos;
+
+  if (n == 0 && !status && !damage.present) return 0;
+  if (damage.target == NULL && (n > 0 || status || damage.present)) damage.full = 1;
+
+  frameDrawCalls = 0;
+  frameGlyphs = 0;
+  glyphCache.frame++;
+  if (damage.target) SDL_SetRenderTarget(renderer, damage.target);
+  if (damage.full) {
+    SDL_SetRenderDrawColor(renderer, 10, 10, 10, 255);
+    SDL_RenderClear(renderer);
+    rects[0] = (SDL_Rect){0, 0, SCREEN_WIDTH, TEXT_AREA_HEIGHT};
+    from[0] = first;
+    to[0] = last;
+    n = 1;
+    status = 1;
+  }
+  for (int k = 0; k < n; k++) {
+    SDL_SetRenderClipRect(renderer, &rects[k]);
+    if (!damage.full) {
+      SDL_FRect f = {rects[k].x, rects[k].y, rects[k].w, rects[k].h};
+      SDL_SetRenderDrawColor(renderer, 10, 10, 10, 255);
+      SDL_RenderFillRect(renderer, &f);
+      frameDrawCalls++;
+    }
+    PROF(PROF_TEXT, {
+      renderText(0, 0, from[k], to[k]);
+      glyphs_flush();
+    });
+    PROF(PROF_CURSOR, renderCursor(renderer, cursor, cursor_Pos, cursor_Line));
+  }
+  SDL_SetRenderClipRect(renderer, NULL);
+  if (status) {
+    SDL_Rect bar = {0, TEXT_AREA_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT - TEXT_AREA_HEIGHT};
+    renderStatus(&bar, panel, !damage.full);
+  } else if (n > 0 && statsKey != damage.statsKey) {
+    //the counter alone never causes a frame, it would keep changing itself
+    SDL_Rect stats = {SCREEN_WIDTH - 14 * 8, TEXT_AREA_HEIGHT, 14 * 8, SCREEN_HEIGHT - TEXT_AREA_HEIGHT};
+    renderStatus(&stats, panel, 1);
+  }
+  if (status || n > 0) damage.statsKey = statsKey;
+  if (prof.overlay) prof_render(&prof);
+
+  if (damage.target) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderTexture(renderer, damage.target, NULL, NULL);
+    frameDrawCalls++;
+  }
+  PROF(PROF_PRESENT, SDL_RenderPresent(renderer));
+  damage.full = 0;
+  damage.present = 0;
+  damage.scrollX = scrollX;
+  damage.scrollY = scrollY;
+  damage.textKey = textKey;
+  damage.statusKey = statusKey;
+  return 1;
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//frame scheduler
+void scheduler_init(FrameScheduler *f, int uncapped) {
+  memset(f, 0, sizeof(*f));
+  f->uncapped = uncapped;
+  f->vsync = !uncapped && SDL_SetRenderVSync(renderer, 1);
+  if (!f->vsync) SDL_SetRenderVSync(renderer, 0);
+  const SDL_DisplayMode *mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+  float hz = mode && mode->refresh_rate > 0 ? mode->refresh_rate : 60.0f;
+  f->interval = (Uint64)(1e9 / hz);
+  f->benchAt = SDL_GetTicksNS();
+}
+
+void scheduler_input(FrameScheduler *f, Uint64 timestamp) {
+  if (f->inputAt == 0) f->inputAt = timestamp ? timestamp : SDL_GetTicksNS();
+}
+
+int scheduler_collect(FrameScheduler *f, SDL_Event *e) {
+  //vsync paces in Present, uncapped does not wait at all
+  if (f->vsync || f->uncapped) return 0;
+  Uint64 now = SDL_GetTicksNS();
+  Uint64 until = f->lastPresent + f->interval;
+  if (f->inputAt && until > f->inputAt + FRAME_LATENCY_NS) until = f->inputAt + FRAME_LATENCY_NS;
+  if (until <= now) return 0;
+  Sint32 ms = (Sint32)((until - now) / 1000000); //rounded down, never past the budget
+  if (ms <= 0) return 0;
+  return SDL_WaitEventTimeout(e, ms);
+}
+
+void scheduler_presented(FrameScheduler *f, int drawn) {
+  Uint64 now = SDL_GetTicksNS();
+  if (drawn) {
+    f->lastPresent = now;
+    if (f->inputAt && now > f->inputAt) {
+      Uint64 latency = now - f->inputAt;
+      f->latencySum += latency;
+      if (latency > f->latencyMax) f->latencyMax = latency;
+      f->frames++;
+    }
+  }
+  //input that changed nothing had nothing to present
+  f->inputAt = 0;
+  if (f->uncapped) {
+    f->benchFrames++;
+    if (now - f->benchAt >= 1000000000ull) {
+      SDL_Log("Uncapped: %.1f fps", f->benchFrames * 1e9 / (now - f->benchAt));
+      f->benchFrames = 0;
+      f->benchAt = now;
+    }
+  }
+}
+
+void scheduler_report(const FrameScheduler *f) {
+  if (f->frames == 0) return;
+  SDL_Log("Input to present: %.2f ms avg, %.2f ms max over %llu frames (%s)",
+          f->latencySum / 1e6 / f->frames, f->latencyMax / 1e6,
+          (unsigned long long)f->frames, f->vsync ? "vsync" : f->uncapped ? "uncapped" : "paced");
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//profiler
+static const char *profNames[PROF_ROWS] = {
+  "input", "text", "status", "cursor", "present", "frame", "quads", "draws"
+};
+
+#define PROF_X (SCREEN_WIDTH - 18 * 8)
+
+void prof_init(Profiler *p, const char *dumpPath) {
+  memset(p, 0, sizeof(*p));
+  for (int k = 0; k < PROF_ROWS; k++) {
+    char label[24];
+    snprintf(label, sizeof(label), "%-8s%s", profNames[k], k < PROF_COUNT ? "us " : "   ");
+    CustomString_init(&p->rows[k], 2, 2, PROF_X, 2 + k * FONT_SIZE);
+    CustomString_Add(&p->rows[k], label, 0, 0, 0, 0, 0);
+    CustomString_Add(&p->rows[k], NULL, 1, 1, strlen(label) - 1, 0, 1);
+  }
+  if (dumpPath == NULL) return;
+  p->dump = fopen(dumpPath, "w");
+  if (p->dump == NULL) {
+    SDL_Log("Could not open profile dump %s", dumpPath);
+    return;
+  }
+  size_t n = strlen(dumpPath);
+  p->json = n >= 5 && strcmp(dumpPath + n - 5, ".json") == 0;
+  if (p->json) {
+    fputs("[\n", p->dump);
+  } else {
+    for (int k = 0; k < PROF_ROWS; k++) {
+      fprintf(p->dump, "%s%s%s", k ? "," : "frame,", profNames[k], k < PROF_COUNT ? "_us" : "");
+    }
+    fputc('\n', p->dump);
+  }
+  p->on = 1;
+}
+
+void prof_toggle(Profiler *p) {
+  p->overlay = !p->overlay;
+  p->on = p->overlay || p->dump != NULL;
+  //the overlay covers text that has to come back
+  damage.full = 1;
+}
+
+void prof_frame_end(Profiler *p, int drawn) {
+  if (!p->on) return;
+  if (drawn) {
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 v[PROF_ROWS];
+    for (int k = 0; k < PROF_COUNT; k++) v[k] = p->ticks[k] * 1000000 / freq;
+    v[PROF_COUNT] = frameGlyphs;
+    v[PROF_COUNT + 1] = frameDrawCalls;
+    if (p->dump) {
+      if (p->json) {
+        fprintf(p->dump, "%s{\"frame\":%llu", p->frames ? ",\n" : "", (unsigned long long)p->frames);
+        for (int k = 0; k < PROF_ROWS; k++) {
+          fprintf(p->dump, ",\"%s%s\":%llu", profNames[k], k < PROF_COUNT ? "_us" : "", (unsigned long long)v[k]);
+        }
+        fputc('}', p->dump);
+      } else {
+        fprintf(p->dump, "%llu", (unsigned long long)p->frames);
+        for (int k = 0; k < PROF_ROWS; k++) fprintf(p->dump, ",%llu", (unsigned long long)v[k]);
+        fputc('\n', p->dump);
+      }
+    }
+    for (int k = 0; k < PROF_ROWS; k++) {
+      CustomString_Update(&p->rows[k], NULL, 1, 1, p->rows[k].activeSegs[1], (int)v[k], 1);
+    }
+    p->frames++;
+  }
+  memset(p->ticks, 0, sizeof(p->ticks));
+}
+
+void prof_render(Profiler *p) {
+  SDL_FRect box = {PROF_X - 4, 0, SCREEN_WIDTH - PROF_X + 4, PROF_ROWS * FONT_SIZE + 4};
+  SDL_SetRenderDrawColor(renderer, 30, 30, 45, 255);
+  SDL_RenderFillRect(renderer, &box);
+  frameDrawCalls++;
+  for (int k = 0; k < PROF_ROWS; k++) CustomString_Render(&p->rows[k]);
+  glyphs_flush();
+}
+
+void prof_free(Profiler *p) {
+  for (int k = 0; k < PROF_ROWS; k++) CustomString_free(&p->rows[k]);
+  if (p->dump) {
+    if (p->json) fputs("\n]\n", p->dump);
+    fclose(p->dump);
+  }
+  p->dump = NULL;
+  p->on = 0;
+}
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//input recording
+int recorder_open(Recorder *r, const char *path) {
+  memset(r, 0, sizeof(*r));
+  r->io = SDL_IOFromFile(path, "wb");
+  if (r->io == NULL) {
+    SDL_Log("Could not open recording %s: %s", path, SDL_GetError());
+    return -1;
+  }
+  if (!SDL_WriteU32LE(r->io, REC_MAGIC) || !SDL_WriteU32LE(r->io, REC_VERSION)) {
+    recorder_close(r);
+    return -1;
+  }
+  return 0;
+}
+
+void recorder_event(Recorder *r, const SDL_Event *e) {
+  if (r->io == NULL) return;
+  Uint64 at = e->common.timestamp;
+  if (r->count == 0) r->start = at;
+  size_t len = 0;
+  const char *text = NULL;
+  char *clip = NULL;
+  if (e->type == SDL_EVENT_TEXT_INPUT) {
+    text = e->text.text;
+    len = strlen(text);
+    if (len > REC_MAX_TEXT) len = REC_MAX_TEXT;
+  } else if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_V && (e->key.mod & SDL_KMOD_CTRL)) {
+    //the clipboard is input too, a replay elsewhere would paste something else
+    clip = SDL_GetClipboardText();
+    text = clip;
+    len = clip ? strlen(clip) : 0;
+    if (len > REC_MAX_CLIP) len = REC_MAX_CLIP;
+  }
+  int ok = SDL_WriteU64LE(r->io, at - r->start) &&
+           SDL_WriteU32LE(r->io, e->type) &&
+           SDL_WriteU32LE(r->io, e->type == SDL_EVENT_KEY_DOWN ? e->key.key : 0) &&
+           SDL_WriteU16LE(r->io, e->type == SDL_EVENT_KEY_DOWN ? e->key.mod : 0) &&
+           SDL_WriteU32LE(r->io, (Uint32)len) &&
+           (len == 0 || SDL_WriteIO(r->io, text, len) == len);
+  SDL_free(clip);
+  if (!ok) {
+    //a cut recording still replays up to here
+    SDL_Log("Recording stopped: %s", SDL_GetError());
+    recorder_close(r);
+    return;
+  }
+  r->count++;
+}
+
+void recorder_close(Recorder *r) {
+  if (r->io) SDL_CloseIO(r->io);
+  r->io = NULL;
+}
+
+int record_begin(SDL_IOStream *io) {
+  Uint32 magic, version;
+  if (!SDL_ReadU32LE(io, &magic) || !SDL_ReadU32LE(io, &version)) return -1;
+  return magic == REC_MAGIC && version == REC_VERSION ? 0 : -1;
+}
+
+int record_read(SDL_IOStream *io, RecordedEvent *ev) {
+  Uint32 type, key, len;
+  Uint16 mod;
+  if (!SDL_ReadU64LE(io, &ev->at)) return 0;
+  if (!SDL_ReadU32LE(io, &type) || !SDL_ReadU32LE(io, &key) ||
+      !SDL_ReadU16LE(io, &mod) || !SDL_ReadU32LE(io, &len)) {
+    return -1;
+  }
+  char *dst = ev->text;
+  if (type == SDL_EVENT_TEXT_INPUT) {
+    if (len > REC_MAX_TEXT) return -1;
+  } else {
+    //recorded clipboard of a Ctrl+V
+    if (len > REC_MAX_CLIP) return -1;
+    if (len + 1 > ev->clipCap) {
+      char *clip = realloc(ev->clip, len + 1);
+      if (clip == NULL) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      ev->clip = clip;
+      ev->clipCap = len + 1;
+    }
+    dst = ev->clip;
+  }
+  if (len > 0 && SDL_ReadIO(io, dst, len) != len) return -1;
+  dst[len] = '\0';
+  if (dst != ev->text) ev->text[0] = '\0';
+  memset(&ev->event, 0, sizeof(ev->event));
+  ev->event.type = type;
+  ev->event.common.timestamp = ev->at;
+  if (type == SDL_EVENT_KEY_DOWN) {
+    ev->event.key.key = key;
+    ev->event.key.mod = mod;
+    ev->event.key.down = true;
+  } else if (type == SDL_EVENT_TEXT_INPUT) {
+    ev->event.text.text = ev->text;
+  }
+  return 1;
+}
+
+void record_free(RecordedEvent *ev) {
+  free(ev->clip);
+  ev->clip = NULL;
+  ev->clipCap = 0;
+}
+
+Uint64 buffer_hash(const Buffer *b) {
+  Uint64 h = 14695981039346656037ULL;
+  for (size_t i = 0; i < b->nlines; i++) {
+    const String *s = buffer_get_line(b, i);
+    for (size_t k = 0; k < s->length; k++) h = (h ^ (unsigned char)s->data[k]) * 1099511628211ULL;
+  }
+  return h;
+}
+///////////////////////////////////////////////////////////////
+
+void openCurFile(currFile *file,const char* path) {
+  file->path = path;
+  file->file = SDL_IOFromFile(path, "rb");//binary, saves write the bytes back as read
+  if (file->file == NULL) {
+    SDL_Log("Error opening file: %s", SDL_GetError());
+
+    // Handle error
+  } else {
+    Sint64 file_size = SDL_GetIOSize(file->file);
+    SDL_Log("File size: %ld bytes", file_size);
+  }
+}
+
+//map the file read only, lines index straight into the mapping,
+//fd stays open so saves can copy unedited ranges in kernel
+static char* mapFile(const char *path, size_t *size, int *fd) {
+#ifdef SE_HAVE_MMAP
+  *fd = open(path, O_RDONLY);
+  if (*fd < 0) return NULL;
+  struct stat st;
+  void *m = MAP_FAILED;
+  if (fstat(*fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, *fd, 0);
+  }
+  if (m == MAP_FAILED) {
+    close(*fd);
+    *fd = -1;
+    return NULL;
+  }
+  *size = st.st_size;
+  return m;
+#else
+  (void)path;
+  (void)size;
+  *fd = -1;
+  return NULL;
+#endif
+}
+
+//fallback, read the stream in large chunks into one heap block
+static char* slurpFile(SDL_IOStream *io, size_t *size) {
+  Sint64 hint = SDL_GetIOSize(io);
+  size_t cap = hint > 0 ? (size_t)hint + 1 : READ_CHUNK;
+  size_t len = 0;
+  char *data = malloc(cap);
+  if (data == NULL) return NULL;
+  for (;;) {
+    if (len == cap) {
+      char *grown = realloc(data, cap * 2);
+      if (grown == NULL) break;
+      data = grown;
+      cap *= 2;
+    }
+    size_t want = cap - len < READ_CHUNK ? cap - len : READ_CHUNK;
+    size_t got = SDL_ReadIO(io, data + len, want);
+    if (got == 0) break;
+    len += got;
+  }
+  *size = len;
+  return data;
+}
+
+//lines of the file bytes in data, the buffer takes them over
+static void buffer_load_data(Buffer *buffer, char *data, size_t size, int mapped) {
+  if (data != NULL && size >= LOADER_ASYNC_MIN &&
+      buffer_load_async(buffer, data, size, mapped) == 0) {
+    //first lines show up with the next loadEventType
+    return;
+  }
+  if (data != NULL && size > 0) {
+    buffer_load_view(buffer, data, size, mapped);
+#ifdef SE_HAVE_MMAP
+    if (mapped) madvise(data, size, MADV_NORMAL);
+#endif
+  } else {
+    free(data);
+  }
+  //always leave a line for the cursor
+  if (buffer->nlines == 0) {
+    buffer_insert_line(buffer, 0, line_new(&buffer->pool));
+  }
+}
+
+void readFile(currFile *cfile,Buffer *buffer) {
+  buffer->path = malloc(strlen(cfile->path) + 1);
+  if (buffer->path == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  strcpy(buffer->path, cfile->path);
+  Sint64 fileSize = cfile->file ? SDL_GetIOSize(cfile->file) : -1;
+  if (fileSize > 0 && (streamForce || fileSize >= STREAM_THRESHOLD)) {
+    //too big to index up front, lines arrive through stream_poll
+    buffer->stream = stream_open(cfile->path, streamBudget, &buffer->pool);
+    if (buffer->stream != NULL) return;
+  }
+
+  size_t size = 0;
+  int mapped = 1;
+  int fd = -1;
+  char *data = mapFile(cfile->path, &size, &fd);
+  if (data != NULL) {
+    buffer->baseFd = fd;
+#ifdef SE_HAVE_MMAP
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif
+  } else if (cfile->file != NULL) {
+    mapped = 0;
+    data = slurpFile(cfile->file, &size);
+  }
+  buffer_load_data(buffer, data, size, mapped);
+}
+
+
+void closeCurFile(currFile *file) {
+  if (file->file) SDL_CloseIO(file->file); // Close the file when done
+}
+
+///////////////////////////////////////////////////////////////
+//file tabs
+size_t buffer_memory(const Buffer *b) {
+  size_t n = b->pool.bytes + sizeof(Line*) * b->capacity;
+  n += 2 * sizeof(IndexCount) * b->index.cap;
+  n += b->undo.arenaCap + sizeof(UndoOp) * b->undo.opsCap;
+  if (b->base && !b->baseMapped) n += b->baseSize;
+  if (b->loader) {
+    //a parked load keeps making headers in its own pool until it is merged
+    SDL_LockMutex(b->loader->lock);
+    n += sizeof(Line*) * b->loader->readyCap + sizeof(Line) * (b->nlines + b->loader->nready);
+    SDL_UnlockMutex(b->loader->lock);
+  }
+  if (b->stream) {
+    n += b->stream->resident;
+    SDL_LockMutex(b->stream->lock);
+    n += sizeof(StreamPage) * b->stream->foundCap;
+    SDL_UnlockMutex(b->stream->lock);
+  }
+  return n;
+}
+
+void buffer_move(Buffer *dst, Buffer *src) {
+  *dst = *src;
+  //the first large body points back at the list head inside the pool
+  if (dst->pool.big.next) dst->pool.big.next->prev = &dst->pool.big;
+  if (dst->stream) dst->stream->pool = &dst->pool;
+}
+
+void tabs_open(char **paths, size_t n, size_t budget) {
+  FileTabs *t = &fileTabs;
+  t->tabs = calloc(n, sizeof(FileTab));
+  if (t->tabs == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t k = 0; k < n; k++) {
+    t->tabs[k].path = malloc(strlen(paths[k]) + 1);
+    if (t->tabs[k].path == NULL) {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    strcpy(t->tabs[k].path, paths[k]);
+    t->tabs[k].state = FILETAB_CLOSED;
+    t->tabs[k].baseFd = -1;
+  }
+  t->ntabs = n;
+  t->current = n;
+  t->budget = budget;
+  t->clock = 0;
+}
+
+//back to the mapping when the lines came from it unchanged, else to the path
+static void tab_evict(FileTab *tab) {
+  Buffer *b = &tab->buffer;
+  tab->state = FILETAB_CLOSED;
+  if (b->baseMapped && !b->saved && b->loader == NULL && b->stream == NULL) {
+    tab->base = b->base;
+    tab->baseSize = b->baseSize;
+    tab->baseFd = b->baseFd;
+    b->base = NULL;
+    b->baseSize = 0;
+    b->baseFd = -1;
+    tab->state = FILETAB_MAPPED;
+  }
+  buffer_free(b);
+}
+
+void tabs_trim(void) {
+  FileTabs *t = &fileTabs;
+  size_t used = t->current < t->ntabs ? buffer_memory(&buffer) : 0;
+  for (size_t k = 0; k < t->ntabs; k++) {
+    if (k != t->current && t->tabs[k].state == FILETAB_OPEN) used += buffer_memory(&t->tabs[k].buffer);
+  }
+  while (used > t->budget) {
+    FileTab *victim = NULL;
+    for (size_t k = 0; k < t->ntabs; k++) {
+      FileTab *c = &t->tabs[k];
+      if (k == t->current || c->state != FILETAB_OPEN || c->buffer.modified) continue;
+      if (victim == NULL || c->lastShown < victim->lastShown) victim = c;
+    }
+    if (victim == NULL) return; //the rest is shown or has unsaved edits
+    used -= buffer_memory(&victim->buffer);
+    tab_evict(victim);
+  }
+}
+
+static void tabs_title(void) {
+  if (window == NULL) return;
+  const FileTab *tab = &fileTabs.tabs[fileTabs.current];
+  const char *name = strrchr(tab->path, '/');
+  char title[512];
+  snprintf(title, sizeof(title), "%s [%zu/%zu]", name ? name + 1 : tab->path,
+           fileTabs.current + 1, fileTabs.ntabs);
+  SDL_SetWindowTitle(window, title);
+}
+
+void tabs_show(size_t k) {
+  FileTabs *t = &fileTabs;
+  if (k >= t->ntabs || k == t->current) return;
+  //prompts and matches belong to the buffer going away
+  search_clear(&search);
+  search.active = 0;
+  gotoPrompt.active = 0;
+  if (t->current < t->ntabs) {
+    FileTab *cur = &t->tabs[t->current];
+    int first, last;
+    view_lines(&first, &last);
+    cur->cursorLine = cursor_Line;
+    cur->cursorPos = cursor_Pos;
+    cur->topLine = first;
+    cur->scrollX = scrollX;
+    buffer_move(&cur->buffer, &buffer);
+  }
+  FileTab *tab = &t->tabs[k];
+  if (tab->state == FILETAB_OPEN) {
+    buffer_move(&buffer, &tab->buffer);
+  } else {
+    buffer_init(&buffer, 1);
+    if (tab->state == FILETAB_MAPPED) {
+      //the newline scan again, the file is not read twice
+      buffer.path = malloc(strlen(tab->path) + 1);
+      if (buffer.path == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+      }
+      strcpy(buffer.path, tab->path);
+      buffer.baseFd = tab->baseFd;
+      buffer_load_data(&buffer, tab->base, tab->baseSize, 1);
+      tab->base = NULL;
+      tab->baseFd = -1;
+    } else {
+      currFile cfile;
+      openCurFile(&cfile, tab->path);
+      readFile(&cfile, &buffer);
+      closeCurFile(&cfile);
+    }
+    tab->state = FILETAB_OPEN;
+  }
+  t->current = k;
+  tab->lastShown = ++t->clock;
+  //streams keep one row per line, only their view goes unwrapped
+  wrapLines = 0;
+  if (wrapWanted && fontMap[' '].width > 0) {
+    size_t cols = (SCREEN_WIDTH - WRAP_MARGIN) / fontMap[' '].width;
+    if (buffer.wrapCols == cols) {
+      wrapLines = 1;
+    } else if (buffer_set_wrap(&buffer, cols) == 0) {
+      wrapLines = 1;
+      wrap_cache_free();
+    }
+  }
+  //lines a parked load published meanwhile, then the view as it was left
+  if (buffer.loader) buffer_poll_load(&buffer);
+  buffer_wait_lines(&buffer, tab->cursorLine + 1);
+  cursor_Line = tab->cursorLine < buffer.nlines ? tab->cursorLine : 0;
+  const String *line = buffer_get_line(&buffer, cursor_Line);
+  cursor_Pos = line && tab->cursorPos <= line->length ? tab->cursorPos : 0;
+  cursorGoal = SIZE_MAX;
+  scrollX = wrapLines ? 0 : tab->scrollX;
+  size_t top = tab->topLine < buffer.nlines ? tab->topLine : cursor_Line;
+  if (wrapLines && buffer_line_row(&buffer, top, &top) != 0) top = 0;
+  scrollY = (int)top * FONT_SIZE;
+  tempS = (int)top + 41;
+  scroll_to_cursor();
+  damage.full = 1;
+  tabs_title();
+  tabs_trim();
+}
+
+void tabs_cycle(int dir) {
+  FileTabs *t = &fileTabs;
+  if (t->ntabs < 2) return;
+  size_t cur = t->current < t->ntabs ? t->current : 0;
+  tabs_show((cur + t->ntabs + dir) % t->ntabs);
+}
+
+void tabs_free(void) {
+  FileTabs *t = &fileTabs;
+  for (size_t k = 0; k < t->ntabs; k++) {
+    FileTab *tab = &t->tabs[k];
+    if (tab->state == FILETAB_OPEN && k != t->current) buffer_free(&tab->buffer);
+#ifdef SE_HAVE_MMAP
+    if (tab->state == FILETAB_MAPPED) {
+      munmap(tab->base, tab->baseSize);
+      if (tab->baseFd >= 0) close(tab->baseFd);
+    }
+#endif
+    free(tab->path);
+  }
+  if (t->current < t->ntabs) buffer_free(&buffer);
+  col_cache_free();
+  wrap_cache_free();
+  free(t->tabs);
+  memset(t, 0, sizeof(*t));
+}
+///////////////////////////////////////////////////////////////
@@ -0,0 +1,1246 @@
+#ifndef SIMPLE_EDITOR_H
+#define SIMPLE_EDITOR_H
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //madvise, copy_file_range
+#endif
+#include <math.h>
+#include <stddef.h>
+#define SDL_MAIN_HANDLED
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <string.h>
+#include <stdlib.h>
+#include <uchar.h>
+#include <stdio.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#define SE_HAVE_MMAP
+#endif
+#ifdef __linux__
+#define SE_HAVE_COPY_RANGE
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SE_HAVE_X86
+#endif
+
+//GhbdtnПривет😊
+#define SCREEN_WIDTH 800
+#define SCREEN_HEIGHT 600
+#define FONT_SIZE 14
+#define TEXT_AREA_HEIGHT 575 //status bar starts below
+#define MAX_TEXT_LENGTH 1024
+#define TAB_WIDTH 4 //cells a tab byte advances
+#define READ_CHUNK (1 << 20) //fallback loader read size
+
+
+////////////////////////////////
+// need edit
+// numberslines
+// fixsurfaceFORtext
+// fixposendcursor
+// add menubar
+
+// scan-build20 clang20 -faddress=sanitizer
+// -g3 OpenglSDL2Window5.c -o OpenglSDL2Window5
+// -I/usr/local/include -L/usr/local/lib -DSHM
+// -lSDL2 -lSDL2main -lSDL2_ttf -lm
+
+// clang20 -g3 OpenglSDL2Window5.c -o OpenglSDL2Window5
+// -I/usr/local/include -L/usr/local/lib -DSHM -lSDL2
+// -lSDL2main -lSDL2_ttf -lm
+
+// valgrind ./OpenglSDL2Window5
+// valgrind env SDL_VIDEODRIVER=x11 ./OpenglSDL2Window5 //set driver
+// g3 - for debug for core
+
+// clang20 -Wall -Wpedantic -Wextra -Weverything
+//  -g3 -lm -fsanitize=undefined OpenglSDL2Window5.c
+// -o OpenglSDL2Window5 -I/usr/local/include
+// -L/usr/local/lib -DSHM -lSDL2 -lSDL2main -lSDL2_ttf -lm
+
+//////////////////////////////////////////////////////////////
+//tools
+void getWindowGW(int *w);
+void getWindowGH(int *h);
+
+
+// extract int number from int to string rep
+char* getC(int N);
+//tools
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//simd kernels, simd_init picks AVX2 or scalar versions at runtime
+typedef struct {
+  const char *name;
+  size_t (*count_newlines)(const char *p, size_t n);
+  const char* (*find_newline)(const char *p, size_t n); //memchr for '\n'
+  size_t (*count_utf8)(const char *p, size_t n); //codepoints
+  int (*validate_utf8)(const char *p, size_t n); //1 valid
+  const char* (*find_substr)(const char *p, size_t n, const char *needle, size_t m); //memmem
+} SimdKernels;
+
+extern SimdKernels simd;
+
+void simd_init(void);
+
+//length of the valid UTF-8 sequence at i, 0 when malformed
+size_t utf8_seq_len(const char *p, size_t n, size_t i);
+
+//start of the codepoint before i, a malformed byte counts as one
+size_t utf8_prev(const char *p, size_t i);
+
+//end of the grapheme cluster at i, combining marks, variation selectors,
+//ZWJ sequences, emoji modifiers, flag pairs and CR LF stay together
+size_t utf8_next_grapheme(const char *p, size_t n, size_t i);
+
+//start of the grapheme cluster ending at i
+size_t utf8_prev_grapheme(const char *p, size_t n, size_t i);
+
+//kernel throughput in GB/s for every available implementation
+void simd_bench(size_t megabytes);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//glyph
+typedef struct {
+  char ch;
+  SDL_FRect srcRect; //rect
+  int width;        //width
+  Uint8 page; //0 ASCII atlas, k glyph cache page k - 1
+} CharInfo;
+
+extern int fWidth, fHeight;
+
+extern SDL_Window* window;
+extern SDL_Renderer* renderer;
+extern TTF_Font* font;
+extern SDL_Texture* fontAtlas;
+
+extern int scrollX;
+extern int scrollY;
+extern SDL_Rect tempRect;
+extern int tempS;
+
+
+extern CharInfo fontMap[128]; //ASCII atlas, other codepoints go through glyphCache
+extern int atlasW, atlasH; //atlas size for texture coords
+extern int textLength;
+///////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//glyph batch, quads with per vertex colour flushed by one SDL_RenderGeometry
+typedef struct {
+  SDL_Vertex *vertices; //4 per quad
+  int *indices; //6 per quad, fixed pattern filled on grow
+  int nquads;
+  int capacity; //in quads
+  SDL_Texture *texture;
+  float texW; //texture size for texture coords
+  float texH;
+} GlyphBatch;
+
+void batch_init(GlyphBatch *b, SDL_Texture *texture, int quads);
+
+void batch_glyph(GlyphBatch *b, const CharInfo *chInfo, float x, float y, Uint8 r, Uint8 g, Uint8 bl);
+
+void batch_flush(GlyphBatch *b);
+
+void batch_free(GlyphBatch *b);
+
+extern GlyphBatch glyphBatch;
+extern int frameDrawCalls; //draw calls issued in the current frame
+extern int frameGlyphs; //glyph quads submitted in the current frame
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//glyph cache, codepoints past ASCII are rasterized on first use and packed
+//on shelves into atlas pages with partial texture updates, when every page
+//is full the least recently drawn page is emptied and refilled
+#define GLYPH_PAGE_SIZE 512
+#define GLYPH_MAX_PAGES 4
+#define GLYPH_PAD 1 //keeps filtering from bleeding in neighbours
+
+typedef struct {
+  int y;
+  int h;
+  int x; //next free column
+} GlyphShelf;
+
+typedef struct {
+  SDL_Texture *texture;
+  GlyphBatch batch; //quads drawn from this page
+  GlyphShelf *shelves;
+  int nshelves;
+  int shelfCap;
+  int top; //rows below this are unused
+  Uint64 lastUse; //frame the page was last drawn from
+} GlyphPage;
+
+typedef struct {
+  Uint32 cp; //0 empty slot
+  CharInfo info;
+} CachedGlyph;
+
+typedef struct {
+  GlyphPage pages[GLYPH_MAX_PAGES];
+  int npages;
+  CachedGlyph *table; //open addressing on the codepoint
+  size_t tableCap;
+  size_t count;
+  Uint64 frame;
+  int rasterized; //glyphs rendered so far, for the stats
+  int evictions;
+} GlyphCache;
+
+extern GlyphCache glyphCache;
+
+void glyph_cache_init(GlyphCache *g);
+
+//glyph of cp, rasterized and uploaded only on a miss
+const CharInfo* glyph_cache_get(GlyphCache *g, Uint32 cp);
+
+void glyph_cache_free(GlyphCache *g);
+
+//glyph of the character at s[*i], *i moves past it, malformed bytes show
+//as U+FFFD one byte at a time
+const CharInfo* glyph_at(const char *s, size_t n, size_t *i);
+
+//queue a quad on the batch of the glyph's texture
+void glyph_draw(const CharInfo *chInfo, float x, float y, Uint8 r, Uint8 g, Uint8 bl);
+
+//flush the ASCII batch and every page batch
+void glyphs_flush(void);
+///////////////////////////////////////////////////////////////
+
+
+//capacity 0 with data set means a view into the loaded file that is not
+//owned and not terminated, it gets copied on the first change
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+} String;
+
+void string_init(String *s);
+
+int string_reserve(String *s, size_t need);
+
+int string_append_str(String *s, const char *str);
+
+int string_append_len(String *s, const char *str, size_t len);
+
+int string_append_char(String *s, char c);
+
+void string_free(String *s);
+///////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+//syntax token kinds, plain text is everything outside the spans
+enum {
+  SYN_TEXT = 0,
+  SYN_COMMENT,
+  SYN_PREPROC,
+  SYN_TYPE,
+  SYN_KEYWORD,
+  SYN_STRING,
+  SYN_NUMBER,
+  SYN_COUNT
+};
+
+//lexer state carried from the end of one line into the next
+enum {
+  LEX_NORMAL = 0,
+  LEX_BLOCK_COMMENT, // inside /* */
+  LEX_STRING // string continued with a trailing backslash
+};
+
+typedef struct {
+  Uint32 start;
+  Uint32 len;
+  Uint8 kind;
+} SynSpan;
+
+//line header, text first so a Line* is also its String*
+typedef struct {
+  String text;
+  SynSpan *spans; //cached tokens, valid when lexDirty is 0
+  int nspans;
+  int spanCap;
+  Uint8 lexIn; //state the spans were lexed with
+  Uint8 lexOut; //state at the end of the line
+  Uint8 lexDirty; //text changed since last lex
+  size_t bytes; //text as counted into the buffer totals, 0 until first touched
+  size_t chars;
+  size_t rows; //visual rows as counted into the index, see buffer_set_wrap
+} Line;
+
+//line storage, headers come from slabs and bodies up to 4 KB from power of
+//two size classes carved out of big blocks, so a buffer drops all its lines
+//by freeing a handful of blocks, not one allocation per line
+#define POOL_BLOCK (256 << 10) //bytes of bodies per block
+#define POOL_SLAB_LINES 2048 //headers per slab
+#define POOL_MIN_CLASS 16
+#define POOL_CLASSES 9 //16 .. 4096 bytes, larger bodies are malloc'd
+
+//in front of bodies above the largest class, they are listed for pool_free
+typedef struct PoolBig {
+  struct PoolBig *prev;
+  struct PoolBig *next;
+} PoolBig;
+
+typedef struct {
+  char *base;
+  size_t size;
+  size_t freeBytes; //on free lists, only counted by pool_reclaim
+} PoolBlock;
+
+typedef struct {
+  PoolBlock *blocks; //slabs and body blocks
+  size_t nblocks;
+  size_t blockCap;
+  Line *slab; //unused headers of the newest slab
+  size_t slabLeft;
+  char *bump; //unused bytes of the newest body block
+  size_t bumpLeft;
+  void *freeClass[POOL_CLASSES]; //released bodies chained through their first bytes
+  Line *freeLines; //released headers chained through text.data
+  PoolBig big;
+  size_t bytes; //malloc'd for the pool, blocks and large bodies
+  size_t released; //block bytes put on free lists since the last pool_reclaim
+} LinePool;
+
+void pool_init(LinePool *p);
+
+//at least size bytes, NULL only when a large body cannot be malloc'd
+void* pool_alloc(LinePool *p, size_t size);
+
+//size is what was asked for, it picks the same class again
+void pool_release(LinePool *p, void *ptr, size_t size);
+
+//hand the blocks of src to dst, lines from src stay valid
+void pool_merge(LinePool *dst, LinePool *src);
+
+//1 when ptr lies in one of the slabs or body blocks of p
+int pool_owns(const LinePool *p, const void *ptr);
+
+//give back slabs and body blocks with nothing live left in them, for pools
+//whose lines come and go like the pages of a streamed file, a no-op until
+//a quarter of the pool has been released since the last call
+void pool_reclaim(LinePool *p);
+
+void pool_free(LinePool *p);
+
+Line* line_new(LinePool *p);
+
+//line borrowing len bytes of the loaded file
+Line* line_new_view(LinePool *p, const char *data, size_t len);
+
+void line_free(LinePool *p, Line *l);
+
+//string_reserve and string_append_len for line text, bodies come from p
+int line_reserve(LinePool *p, String *s, size_t need);
+
+int line_append(LinePool *p, String *s, const char *str, size_t len);
+
+typedef struct StreamFile StreamFile;
+typedef struct BufferLoader BufferLoader;
+
+//undo history, edits are kept as (line, pos, bytes) ops whose bytes are
+//appended to one arena, ops past applied are the redo side
+#define UNDO_DEFAULT_CAP (16 << 20)
+#define UNDO_MERGE_MS 1000 //typing pauses longer than this start a new op,
+                          //timed by event timestamps so replays group alike
+
+enum { UNDO_INSERT, UNDO_DELETE };
+
+typedef struct {
+  size_t line; //where the edit starts
+  size_t pos;
+  size_t at; //bytes live at arena + at
+  size_t len;
+  Uint8 kind;
+} UndoOp;
+
+typedef struct {
+  char *arena;
+  size_t used;
+  size_t arenaCap;
+  UndoOp *ops;
+  size_t nops;
+  size_t opsCap;
+  size_t applied; //ops [0,applied) are done
+  size_t cap; //bytes of arena and ops kept, oldest ops go first
+  int sealed; //next edit does not merge into the last op
+  Uint64 now; //ns timestamp of the input event making the edit
+  Uint64 lastTime; //now of the last edit
+} UndoLog;
+
+//line index, lines are grouped into blocks of up to 2 * INDEX_BLOCK and a
+//Fenwick tree over the blocks keeps prefix sums of lines, bytes,
+//codepoints and visual rows, mapping an offset to a line is O(log n) plus
+//one block scan
+#define INDEX_BLOCK 32
+
+enum { INDEX_LINES, INDEX_BYTES, INDEX_CHARS, INDEX_ROWS, INDEX_FIELDS };
+
+typedef struct {
+  size_t n[INDEX_FIELDS];
+} IndexCount;
+
+typedef struct {
+  IndexCount *blocks; //in line order
+  IndexCount *tree; //Fenwick over blocks, 1 based
+  size_t nblocks;
+  size_t cap;
+  size_t empty; //blocks emptied by removals, dropped when they are half of all
+} LineIndex;
+
+//lines live in a gap array: slots [0,gapStart) hold lines 0..gapStart-1,
+//slots [gapStart+capacity-nlines,capacity) hold the rest, so inserting or
+//removing lines next to the previous edit only touches the gap
+typedef struct {
+  Line **line; //pointer to lines (use buffer_get_line, slots are gapped)
+  size_t nlines; //number of lines
+  size_t capacity; //
+  size_t gapStart; //logical line index where the gap starts
+  size_t currLine;
+  size_t totalSizeChars; //codepoints, kept exact by every line change
+  size_t totalBytes;
+  int stateFlag;//0 scratch,1 openFile
+  size_t lexFrom; //lines before this have valid spans
+  size_t lexTo; //lines after this are not dirty
+  char *base; //loaded file bytes, unedited lines view into them
+  size_t baseSize;
+  int baseMapped; //1 base is mmapped, 0 heap block
+  int baseFd; //file base was mapped from, -1 if none, saves copy from it
+  char *path; //file the buffer came from, target of Ctrl+S
+  int isUtf8; //loaded bytes were valid UTF-8
+  StreamFile *stream; //large file mode, lines come from pages instead
+  BufferLoader *loader; //lines of base still being indexed in the background
+  UndoLog undo;
+  LinePool pool; //every line of the buffer, released at once by buffer_free
+  SDL_RWLock *linesLock; //readers on other threads hold it, line array changes take it for writing
+  size_t damageFrom; //lines [damageFrom, damageTo] changed since the last frame drew them,
+  size_t damageTo; //none when damageFrom > damageTo, SIZE_MAX reaches past the last line
+  LineIndex index; //in memory buffers, streams only map lines through their pages
+  size_t wrapCols; //columns per visual row lines are estimated with, 0 no wrapping
+  int modified; //edited since it was read or saved, such buffers are never evicted
+  int saved; //written since it was read, base no longer matches the file
+} Buffer;
+
+void buffer_init(Buffer* b,int flag);
+//add string
+void buffer_append_str(Buffer* b, const char* str);
+
+int buffer_insert_char(Buffer *b, size_t line_index, size_t position, char c);
+
+//gap array primitives
+int buffer_insert_line(Buffer *b, size_t index, Line *l);
+
+//n lines at once, one gap move and one index update, the buffer owns them after
+int buffer_insert_lines(Buffer *b, size_t index, Line **lines, size_t n);
+
+Line* buffer_remove_line(Buffer *b, size_t index);
+
+//remove and free n lines from index
+void buffer_remove_lines(Buffer *b, size_t index, size_t n);
+
+//mark line text as changed for the highlighter
+void buffer_touch_line(Buffer *b, size_t index);
+
+//lines [from, to] need redrawing, to SIZE_MAX also clears below the last line
+void buffer_damage(Buffer *b, size_t from, size_t to);
+
+void buffer_backspace_test(Buffer *b,int cursor_Line,int cursor_Pos);
+
+//bulk edits, text may span lines, one call is one gap move
+int buffer_insert_str(Buffer *b, size_t line_index, size_t position, const char *s, size_t len);
+
+int buffer_delete_range(Buffer *b, size_t line_index, size_t position, size_t len);
+
+//copy len bytes starting at (line_index, position) to dst, returns bytes copied
+size_t buffer_copy_range(const Buffer *b, size_t line_index, size_t position, size_t len, char *dst);
+
+
+String* buffer_get_line(const Buffer* b, size_t index);
+
+//position mapping through the line index, offsets count from the start of
+//the buffer, all return -1 for streamed buffers which have no index
+//bytes and codepoints in front of line, line nlines gives the totals
+int buffer_line_offset(const Buffer *b, size_t line, size_t *bytes, size_t *chars);
+
+//line and byte position of a byte offset, clamped to the end of the buffer,
+//an offset inside a grapheme cluster goes back to its start
+int buffer_offset_line(const Buffer *b, size_t offset, size_t *line, size_t *pos);
+
+//visual rows in front of line, line nlines gives the total
+int buffer_line_row(const Buffer *b, size_t line, size_t *row);
+
+//line holding visual row and the row within that line, clamped to the last line
+int buffer_row_line(const Buffer *b, size_t row, size_t *line, size_t *rowInLine);
+
+//count every line as ceil(columns / cols) rows, 0 makes each line one row,
+//the layout corrects lines it measures through buffer_set_line_rows, O(n)
+int buffer_set_wrap(Buffer *b, size_t cols);
+
+//measured row count of a line, lines below move so they are damaged
+void buffer_set_line_rows(Buffer *b, size_t index, size_t rows);
+
+Line* buffer_get_line_info(const Buffer* b, size_t index);
+
+//index lines straight over data and take ownership of it
+void buffer_load_view(Buffer *b, char *data, size_t size, int mapped);
+
+//same as buffer_load_view but lines are indexed on a worker thread and
+//appended by buffer_poll_load, returns 0 when the loader started
+int buffer_load_async(Buffer *b, char *data, size_t size, int mapped);
+
+//append lines the loader published, returns 1 when lines were added
+int buffer_poll_load(Buffer *b);
+
+//block until at least n lines exist or the file is fully indexed
+void buffer_wait_lines(Buffer *b, size_t n);
+
+//percent of the file indexed so far, 100 when nothing is loading
+int buffer_load_progress(const Buffer *b);
+
+extern size_t undoCap; //--undo-mb
+
+void undo_init(UndoLog *u, size_t cap);
+
+void undo_free(UndoLog *u);
+
+//the next edit starts a new undo step, called when the cursor moves away
+void undo_seal(UndoLog *u);
+
+//edits from input, recorded in the undo log before they are applied
+int buffer_edit_insert(Buffer *b, size_t line_index, size_t position, const char *s, size_t len);
+
+int buffer_edit_delete(Buffer *b, size_t line_index, size_t position, size_t len);
+
+//revert or reapply one step, the cursor goes to where it happened,
+//returns 0 when there was nothing to do
+int buffer_undo(Buffer *b, size_t *line_index, size_t *position);
+
+int buffer_redo(Buffer *b, size_t *line_index, size_t *position);
+
+//write the buffer to a temp file next to path, fsync and rename it over
+//path, returns 0 on success
+int buffer_save(Buffer *b, const char *path);
+
+void buffer_print(const Buffer* b);
+//free buffer
+void buffer_free(Buffer* b);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//background load, a worker splits the file into line views and publishes
+//them in batches so the first screen paints before the whole file is indexed
+#define LOADER_ASYNC_MIN (4 << 20) //smaller files are indexed in place
+#define LOADER_FIRST_BATCH 256 //enough for the first screen
+#define LOADER_BATCH 16384
+
+struct BufferLoader {
+  SDL_Thread *thread;
+  const char *data; //Buffer.base, owned by the buffer
+  size_t size;
+  int mapped;
+  //filled by the worker, guarded by lock
+  SDL_Mutex *lock;
+  SDL_Condition *progress; //signalled on every publish and when done
+  Line **ready; //lines not yet picked up by buffer_poll_load
+  size_t nready;
+  size_t readyCap;
+  size_t loaded; //bytes indexed
+  int isUtf8;
+  int done;
+  SDL_AtomicInt stop;
+  LinePool pool; //headers made by the worker, merged into the buffer at the end
+};
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//large file streaming, a background scan builds a sparse page index and
+//only pages near the view stay resident, edited pages are kept as an
+//overlay on the original file
+#define STREAM_PAGE_LINES 1024 //lines per page from the scan
+#define STREAM_SCAN_CHUNK (4 << 20)
+#define STREAM_THRESHOLD ((Sint64)1 << 30) //files from 1 GB stream by default
+#define STREAM_DEFAULT_BUDGET (64 << 20)
+
+typedef struct {
+  Uint64 offset; //range in the original file
+  Uint64 size;
+  Uint64 firstLine; //valid for pages below StreamFile.prefixFrom
+  Uint32 nlines;
+  Uint32 cap; //of lines
+  Line **lines; //NULL when not resident
+  char *bytes; //page text, clean lines view into it
+  Uint64 lastUse;
+  int dirty; //edited, never evicted
+} StreamPage;
+
+struct StreamFile {
+  char *path;
+  LinePool *pool; //the buffer's, page lines come and go through it
+  SDL_IOStream *io; //page reads, main thread only
+  int fd; //same file for saves, clean pages are copied from it
+  StreamPage *pages; //main thread only
+  size_t npages;
+  size_t pageCap;
+  size_t prefixFrom; //firstLine is valid for pages before this
+  size_t *residentPages; //indices of pages with lines loaded
+  size_t nresident;
+  size_t residentCap;
+  size_t budget; //bytes of resident pages kept after a trim
+  size_t resident; //bytes held by resident pages
+  Uint64 useClock;
+  //filled by the scanner thread, guarded by lock
+  SDL_Thread *scanner;
+  SDL_Mutex *lock;
+  SDL_Condition *progress; //signalled on every publish and when done
+  StreamPage *found; //pages not yet picked up by stream_poll
+  size_t nfound;
+  size_t foundCap;
+  Uint64 foundChars; //codepoints scanned, not yet picked up
+  Uint64 scanned; //bytes scanned
+  Uint64 fileSize;
+  SDL_AtomicInt stop;
+  SDL_AtomicInt done;
+};
+
+extern int streamForce; //--stream, stream whatever the size
+extern size_t streamBudget; //--budget MB
+extern Uint32 loadEventType; //pushed by background loaders and search workers to wake the main loop
+
+StreamFile* stream_open(const char *path, size_t budget, LinePool *pool);
+
+//pick up pages found by the scanner, returns 1 when lines were added
+int stream_poll(Buffer *b);
+
+Line* stream_line(StreamFile *s, size_t index);
+
+int stream_insert_line(StreamFile *s, size_t index, Line *l);
+
+Line* stream_remove_line(StreamFile *s, size_t index);
+
+void stream_mark_dirty(StreamFile *s, size_t index);
+
+//evict least recently used clean pages until within budget,
+//called once per frame so lines handed out during a frame stay valid
+void stream_trim(StreamFile *s);
+
+void stream_close(StreamFile *s);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//regex, patterns compile to a Thompson NFA, lines are filtered by a lazily
+//built DFA over it and match bounds come from a Pike VM, both linear in the
+//line length so no pattern can blow up like a backtracker
+#define REGEX_MAX_NODES 20000
+#define REGEX_DFA_BUDGET (1 << 20) //bytes of cached DFA states per matcher
+#define REGEX_MAX_FLUSHES 8 //cache resets before a matcher stays on the NFA
+
+typedef struct RegexProg RegexProg;
+
+typedef struct {
+  int set; //offset of the sorted NFA node list in pool
+  int nset;
+  int match;
+} RxState;
+
+//per thread matching state, the program itself is shared read only
+typedef struct {
+  const RegexProg *prog;
+  int *pool; //node lists of DFA states
+  size_t poolLen;
+  size_t poolCap;
+  RxState *states;
+  int nstates;
+  int stateCap;
+  int *trans; //nstates * nclasses, -1 not built yet
+  int *table; //hash of node lists, state + 1
+  int tableCap;
+  int start; //-1 until built
+  size_t bytes; //held by the DFA, flushed past REGEX_DFA_BUDGET
+  int flushes;
+  int nfaOnly; //cache kept thrashing, lines go straight to the Pike VM
+  int *clist; //Pike VM threads, node and start pairs
+  int *nlist;
+  size_t *cstart;
+  size_t *nstart;
+  int *stack;
+  int *scratch;
+  Uint32 *marks;
+  Uint32 gen;
+} RegexMatcher;
+
+//NULL with a message in err when the pattern does not parse
+RegexProg* regex_compile(const char *pattern, size_t len, char *err, size_t errLen);
+
+void regex_free(RegexProg *p);
+
+void regex_matcher_init(RegexMatcher *m, const RegexProg *p);
+
+void regex_matcher_free(RegexMatcher *m);
+
+//leftmost match in the line text[0,n) at or after from, n excludes the
+//line break, returns 1 with the match in [start,end)
+int regex_find(RegexMatcher *m, const char *text, size_t n, size_t from, size_t *start, size_t *end);
+
+//DFA, Pike VM and backtracking throughput, --bench-regex
+void regex_bench(size_t megabytes);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//incremental search, matches are kept per chunk of lines so the view uses
+//finished chunks while the rest is still scanned on the worker pool
+#define SEARCH_CHUNK_LINES 4096
+#define SEARCH_POOL_MIN (1 << 16) //fewer lines than this are scanned inline
+#define SEARCH_SLICE_MS 8 //inline scanning per poll
+#define SEARCH_MAX_QUERY 256
+
+typedef struct {
+  size_t line;
+  size_t pos;
+  size_t len;
+} SearchHit;
+
+typedef struct {
+  size_t from; //lines [from, to)
+  size_t to;
+  SearchHit *hits; //in line, pos order
+  size_t nhits;
+  size_t hitCap;
+  SDL_AtomicInt done;
+} SearchChunk;
+
+typedef struct {
+  int active; //prompt open, typed text goes to the query
+  char query[SEARCH_MAX_QUERY];
+  size_t qlen;
+  int regex; //query is a pattern, Ctrl+R in the prompt toggles it
+  RegexProg *prog; //NULL when the pattern did not compile
+  char error[64];
+  Buffer *buf;
+  SearchChunk *chunks; //only the main thread resizes, under linesLock
+  size_t nchunks;
+  size_t chunkCap;
+  size_t ndone; //finished chunks seen by search_poll
+  size_t nhits;
+  size_t originLine; //jumps look for hits from here
+  size_t originPos;
+  int pendingJump; //direction of a jump waiting for chunks, 0 none
+  int pendingStrict; //hit at the origin itself does not count
+  //chunks [roundFrom, roundFrom + roundLen) are handed out starting at
+  //roundStart, so the part around the cursor finishes first
+  size_t roundFrom;
+  size_t roundLen;
+  size_t roundStart;
+  size_t roundNext;
+  int pooled; //round runs on the workers, else search_poll scans it
+  SDL_Thread **workers;
+  int nworkers;
+  SDL_Mutex *lock; //round fields
+  SDL_Condition *wake;
+  int quit;
+  String status; //prompt shown on the status bar
+} Search;
+
+extern Search search;
+
+void search_init(Search *s);
+
+void search_free(Search *s);
+
+//replace the query and rescan, hits at or after the origin are jumped to
+void search_set_query(Search *s, Buffer *b, const char *q, size_t len);
+
+//stop workers and drop all hits, done before the buffer is edited
+void search_clear(Search *s);
+
+//look for the next (dir 1) or previous (dir -1) hit from line/pos,
+//returns 1 and the hit when it is known now, else the jump stays pending
+int search_jump(Search *s, int dir, size_t *line, size_t *pos);
+
+//account finished chunks, scan inline rounds and retry a pending jump,
+//returns 1 with the position when the pending jump landed
+int search_poll(Search *s, size_t *line, size_t *pos);
+
+//poll until the current round is scanned, replays wait so jumps land the
+//same way every run, returns 1 with the position when a jump landed
+int search_finish(Search *s, size_t *line, size_t *pos);
+
+//hits on line index, NULL when its chunk is not finished
+const SearchHit* search_line_hits(const Search *s, size_t index, size_t *n);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//go to prompt, Ctrl+G, takes "line[:column]" counted from 1 with the column
+//in characters, "@offset" in bytes or "percent%" of the bytes
+#define GOTO_MAX_INPUT 32
+
+typedef struct {
+  int active;
+  char input[GOTO_MAX_INPUT];
+  size_t len;
+  String status; //prompt shown on the status bar
+} GotoPrompt;
+
+extern GotoPrompt gotoPrompt;
+
+//where input points in b, returns 0 when it does not parse or b has no
+//index for an offset
+int goto_target(const Buffer *b, const char *input, size_t len, size_t *line, size_t *pos);
+///////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+//syntax
+//lex one line starting in state, fills spans and lexOut
+void syntax_lex_line(LinePool *p, Line *l, Uint8 state);
+
+//bring spans of lines [0, upto] up to date, relexing dirty lines and
+//following lines until their start state matches the cached one
+void syntax_update(Buffer *b, size_t upto);
+
+//lines [first, last] ready to draw, streaming buffers restart lexing at the
+//view instead of walking from the top of the file
+void syntax_update_view(Buffer *b, size_t first, size_t last);
+
+extern const Uint8 synColors[SYN_COUNT][3];
+//////////////////////////////////////////////////////////////
+
+extern String text;
+
+extern Buffer buffer;
+extern size_t cursor_Line;
+extern size_t cursor_Pos;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//render CUSTOM text////////////////////////////////
+void renderTextA(String *s,int startX, int startY);
+//////////////////////////////////////////////////////
+
+typedef struct StringCustom {
+  String str;
+  int textSegs;
+  int *possSegs;
+  int *activeSegs;
+  int XY[2];
+}CustomString;
+
+
+void CustomString_init(CustomString *s,int tn,int as,int x,int y);
+
+void CustomString_Add(CustomString *s, const char *str, int tn, int n, int as,int XXX, int flag);
+
+void CustomString_Update(CustomString *s,const char *str,int tn, int n, int as,int XXX,int flag);
+
+
+void CustomString_Render(CustomString *s);
+
+void CustomString_free(CustomString *s);
+
+extern CustomString cstring;
+extern CustomString cstats; //draw calls of the last frame
+extern CustomString cload; //percent of the file indexed, shown while loading
+
+//status bar strings for the current buffer
+void status_init(void);
+
+//character total and how far through the file the cursor is
+void status_update(void);
+
+void status_free(void);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//init SDL SDL_ttf, driver NULL lets SDL pick (the benchmark runs "offscreen")
+int initSDL(const char *driver);
+
+//create Texture Atlas
+int createFontAtlas();
+
+//init start text
+void initText();
+extern int countScrollBack;
+extern int flagScroll;
+//work with input
+void handleInput(SDL_Event* e,SDL_Renderer *renderer);
+
+//scroll so the cursor line is on screen after a jump
+void scroll_to_cursor(void);
+
+//lines intersecting the text area, [first, last), wrapped lines on
+//screen are laid out on the way so their rows are exact
+void view_lines(int *first, int *last);
+
+//render text lines [from, to), their spans must be current (syntax_update_view)
+void renderText(int startX, int startY, int from, int to);
+
+///////////////////////////////////////////////////////////////
+//column cache, lines from COL_MIN_LINE bytes get a mark every COL_STRIDE
+//bytes holding the column and pixel x in front of it, so mapping cursor
+//positions scans one stride instead of the whole line, marks of a line go
+//when it is touched or freed
+#define COL_STRIDE 256
+#define COL_MIN_LINE 1024
+#define COL_CACHE_LINES 8
+
+typedef struct {
+  size_t pos; //byte offset, starts a grapheme cluster
+  size_t col; //codepoints in front, a tab counts TAB_WIDTH
+  int x; //pixels in front, valid when the entry hasX
+} ColMark;
+
+typedef struct {
+  const Line *line; //NULL when unused
+  ColMark *marks;
+  size_t nmarks;
+  size_t cap;
+  int hasX; //x needs glyphs, headless runs only ask for columns
+  Uint64 lastUse;
+} ColEntry;
+
+typedef struct {
+  ColEntry entries[COL_CACHE_LINES];
+  Uint64 clock;
+} ColumnCache;
+
+extern ColumnCache colCache;
+
+//text of l changed or l goes away
+void col_forget(const Line *l);
+
+//drop the entries of lines from p, for when it releases them all at once
+void col_forget_pool(const LinePool *p);
+
+void col_cache_free(void);
+
+//display column of byte pos
+size_t line_column(const Line *l, size_t pos);
+
+//start of the cluster at column col, or the end of the text before the line break
+size_t line_pos_at_column(const Line *l, size_t col);
+
+//pixel offset of byte pos in a line, same advances renderText uses
+int line_pixel_x(const Line *l, size_t pos);
+
+//position of the last mark at or left of pixel x and its x in markX,
+//0 for lines without marks, drawing can start there
+size_t line_seek_x(const Line *l, int x, int *markX);
+
+///////////////////////////////////////////////////////////////
+//soft wrap, a row ends where the next glyph would pass the wrap width,
+//scrollY counts rows then and the buffer index maps them to lines, row
+//starts of lines on screen are cached in a set associative table keyed by
+//line so a frame lays out only lines it has not seen, edits drop the entry
+#define WRAP_MARGIN 10 //pixels right of the last column, room for the cursor
+#define WRAP_SETS 64
+#define WRAP_WAYS 4
+
+typedef struct {
+  const Line *line; //NULL when unused
+  Uint32 *starts; //byte each row after the first starts at
+  size_t nstarts;
+  size_t cap;
+  Uint64 lastUse;
+} WrapEntry;
+
+typedef struct {
+  WrapEntry entries[WRAP_SETS * WRAP_WAYS];
+  Uint64 clock;
+} WrapCache;
+
+extern WrapCache wrapCache;
+extern int wrapLines; //soft wrap on for the shown buffer
+extern int wrapWanted; //Alt+Z and --wrap, tabs that cannot wrap leave it alone
+
+//text of l changed or l goes away
+void wrap_forget(const Line *l);
+
+void wrap_forget_pool(const LinePool *p);
+
+void wrap_cache_free(void);
+
+//row starts of buffer line index, laid out on a miss, a row count that
+//differs from the index is corrected
+const WrapEntry* wrap_layout(size_t index);
+
+//turn soft wrap on or off keeping the top line on top, returns -1 for
+//streamed buffers which have no index to count rows in, the setting still
+//applies to the other tabs
+int view_set_wrap(int on);
+
+//pixel rows from the top of the text area to line, negative above the view
+Sint64 view_line_y(size_t line);
+
+//view position of byte pos in line, x from the left of the text area
+void view_locate(size_t line, size_t pos, int *x, Sint64 *y);
+///////////////////////////////////////////////////////////////
+
+//update char and pos
+void updateCharAt(int index, char newChar) ;
+
+typedef struct MicroPanel{
+  SDL_Texture *panelTexture;
+  SDL_Rect panel;
+}Panel;
+
+void initPanel(Panel *p);
+
+void renderPanel(SDL_Renderer *renderer,Panel *p,int x,int y);
+void freePanel(Panel *p);
+
+typedef struct MicroCursor{
+  SDL_Texture *cursorTexture;
+  SDL_Rect cursorRect;
+}Cursor;
+
+void initCursor(Cursor *c);
+
+void renderCursor(SDL_Renderer* renderer,Cursor *c,int x,int y);
+
+void freeCursor(Cursor *c);
+
+///////////////////////////////////////////////////////////////
+//damage tracking
+//frames are drawn into a target texture that keeps the last frame, only the
+//parts that changed since are redrawn and a frame with no damage is skipped
+typedef struct {
+  SDL_Texture *target; //NULL when targets are unsupported, damage redraws all
+  int w; //target size in pixels
+  int h;
+  int full; //redraw everything, first frame and after the target was lost
+  int present; //target is current but the window lost it (expose)
+  int scrollX; //view the target was drawn with
+  int scrollY;
+  size_t cursorLine;
+  size_t cursorPos;
+  Uint64 textKey; //search highlights
+  Uint64 statusKey; //status bar strings
+  Uint64 statsKey; //draw counter, redrawn only along with other damage
+} Damage;
+
+extern Damage damage;
+
+//(re)create the target at the renderer output size, damages everything
+void damage_resize(void);
+
+void damage_free(void);
+
+//draw what changed into the target and present it,
+//returns 0 when nothing changed and the frame was skipped
+int renderFrame(Cursor *cursor, Panel *panel);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//frame scheduler
+//a burst of events is handled first and rendered once, presents are paced
+//by vsync or, without it, by the display refresh, and waiting for the rest
+//of a burst never holds the oldest unpresented input past the budget
+#define FRAME_LATENCY_NS 8000000ull
+
+typedef struct {
+  int vsync; //Present waits for the display
+  int uncapped; //--uncapped, no vsync, no waiting, every frame drawn in full
+  Uint64 interval; //refresh interval in ns
+  Uint64 lastPresent; //SDL_GetTicksNS after the last present
+  Uint64 inputAt; //oldest input not presented yet, 0 none
+  Uint64 latencySum; //input to present over frames
+  Uint64 latencyMax;
+  Uint64 frames;
+  Uint64 benchFrames; //uncapped frames since benchAt
+  Uint64 benchAt;
+} FrameScheduler;
+
+extern FrameScheduler scheduler;
+
+//vsync unless uncapped, refresh interval for pacing when vsync is unavailable
+void scheduler_init(FrameScheduler *f, int uncapped);
+
+//input event at timestamp (ns) is waiting for a present
+void scheduler_input(FrameScheduler *f, Uint64 timestamp);
+
+//queue ran dry, wait for more of the burst while there is time before the
+//next present, returns 1 with the event in e
+int scheduler_collect(FrameScheduler *f, SDL_Event *e);
+
+//after renderFrame, drawn 0 when the frame was skipped
+void scheduler_presented(FrameScheduler *f, int drawn);
+
+//log input to present latency
+void scheduler_report(const FrameScheduler *f);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//profiler
+//scoped timers around the frame stages, F12 shows them over the text and
+//--profile file dumps every drawn frame (.json as JSON, else CSV),
+//while neither is on a timer costs one branch
+enum { PROF_INPUT, PROF_TEXT, PROF_STATUS, PROF_CURSOR, PROF_PRESENT, PROF_FRAME, PROF_COUNT };
+
+#define PROF_ROWS (PROF_COUNT + 2) //stages, glyph quads, draw calls
+
+typedef struct {
+  int on; //timers run, overlay shown or dump open
+  int overlay;
+  FILE *dump;
+  int json;
+  Uint64 frames; //frames recorded
+  Uint64 ticks[PROF_COUNT]; //performance counter ticks in the current frame
+  CustomString rows[PROF_ROWS]; //overlay, values of the last recorded frame
+} Profiler;
+
+extern Profiler prof;
+
+//time call into stage
+#define PROF(stage, call) do { \
+    Uint64 prof_t = prof.on ? SDL_GetPerformanceCounter() : 0; \
+    call; \
+    if (prof.on) prof.ticks[stage] += SDL_GetPerformanceCounter() - prof_t; \
+  } while (0)
+
+//dumpPath NULL for no dump
+void prof_init(Profiler *p, const char *dumpPath);
+
+//F12, show or hide the overlay
+void prof_toggle(Profiler *p);
+
+//after a frame, drawn ones are recorded and shown on the next, timers restart
+void prof_frame_end(Profiler *p, int drawn);
+
+//draw the overlay, called while a frame is drawn
+void prof_render(Profiler *p);
+
+void prof_free(Profiler *p);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//input recording
+//--record appends every event handleInput gets to a file, little endian:
+//"SERC", version, then per event ns since the first one, type, key, mod
+//and the text of text input events, or the clipboard for Ctrl+V so a
+//replay pastes what was pasted when recording, sessions have one file
+//since a replay opens no other tabs
+#define REC_MAGIC 0x43524553u //"SERC"
+#define REC_VERSION 2
+#define REC_MAX_TEXT 1024 //longer text input is cut
+#define REC_MAX_CLIP ((Uint32)1 << 30) //larger recorded pastes are taken as a bad file
+
+typedef struct {
+  SDL_IOStream *io;
+  Uint64 start; //timestamp of the first event
+  size_t count;
+} Recorder;
+
+typedef struct {
+  Uint64 at; //ns since the first event
+  SDL_Event event; //text input points at text
+  char text[REC_MAX_TEXT + 1];
+  char *clip; //recorded clipboard of a Ctrl+V, grown by record_read
+  size_t clipCap;
+} RecordedEvent;
+
+extern Recorder recorder;
+extern int replaying; //events come from a recording, saves are skipped
+extern const char *replayClipboard; //pasted instead of the clipboard while replaying
+
+//0 on success
+int recorder_open(Recorder *r, const char *path);
+
+void recorder_event(Recorder *r, const SDL_Event *e);
+
+void recorder_close(Recorder *r);
+
+//check the header of a recording, 0 on success
+int record_begin(SDL_IOStream *io);
+
+//next event of a recording, 1 read, 0 end, -1 truncated, ev starts zeroed
+int record_read(SDL_IOStream *io, RecordedEvent *ev);
+
+void record_free(RecordedEvent *ev);
+
+//FNV-1a over the text of every line, replays compare it across builds
+Uint64 buffer_hash(const Buffer *b);
+///////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////
+//file tabs, every file on the command line gets one, the shown one lives
+//in the global buffer and the others are parked in their tab with their
+//view, a tab reads its file the first time it is shown and unmodified
+//parked tabs are dropped back to their mapping, oldest shown first, while
+//the open ones hold more than the budget
+#define TABS_DEFAULT_BUDGET ((size_t)512 << 20) //--mem-budget MB
+
+enum {
+  FILETAB_CLOSED, //path only
+  FILETAB_MAPPED, //file mapping kept, lines are indexed again when shown
+  FILETAB_OPEN //whole buffer, parked in buffer unless shown
+};
+
+typedef struct {
+  char *path;
+  int state;
+  Buffer buffer; //parked, see buffer_move
+  char *base; //mapping of a FILETAB_MAPPED tab
+  size_t baseSize;
+  int baseFd;
+  size_t cursorLine; //view to come back to
+  size_t cursorPos;
+  size_t topLine; //first line on screen, rows differ with wrapping
+  int scrollX;
+  Uint64 lastShown;
+} FileTab;
+
+typedef struct {
+  FileTab *tabs; //never moves, parked buffers are pointed into
+  size_t ntabs;
+  size_t current; //ntabs before the first show
+  size_t budget; //bytes open tabs may hold, see buffer_memory
+  Uint64 clock;
+} FileTabs;
+
+extern FileTabs fileTabs;
+
+//heap bytes held by a buffer, mapped file bytes are not counted
+size_t buffer_memory(const Buffer *b);
+
+//move a buffer to another address, the pool and a stream point into it
+void buffer_move(Buffer *dst, Buffer *src);
+
+//a tab per path, nothing is read until a tab is shown
+void tabs_open(char **paths, size_t n, size_t budget);
+
+//park the shown tab and bring tab k into the global buffer
+void tabs_show(size_t k);
+
+//next (dir 1) or previous (dir -1) tab
+void tabs_cycle(int dir);
+
+//evict unmodified parked tabs, least recently shown first, until the open
+//ones fit the budget, run on tab switches and on every loader wakeup
+void tabs_trim(void);
+
+//every tab and the shown buffer
+void tabs_free(void);
+///////////////////////////////////////////////////////////////
+
+typedef struct dirFile{
+  SDL_IOStream *file;
+  const char *path;
+}currFile;
+
+void openCurFile(currFile *file,const char* path);
+
+void readFile(currFile *cfile,Buffer *buffer);
+
+
+void closeCurFile(currFile *file);
+
+#endif